@@ -0,0 +1,241 @@
+#include "ooasm.h"
+#include "computer.h"
+#include "placed_storage.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+// Straight-line workload touching every cell of the memory a few times: a data section,
+// a sweep of arithmetic over consecutive cells and an indirect walk through a pointer cell.
+template <typename Word>
+program<Word> make_workload(size_t mem_size) {
+    std::vector<InstructionPtr<Word>> instructions;
+    instructions.emplace_back(data("ptr", num<Word>(1)));
+    for (size_t i = 1; i < mem_size; i++) {
+        auto cell = static_cast<Word>(i);
+        instructions.emplace_back(mov(mem(num<Word>(cell)), num<Word>(cell)));
+        instructions.emplace_back(add(mem(num<Word>(cell)), mem(num<Word>(cell - 1))));
+        instructions.emplace_back(sub(mem(mem(lea<Word>("ptr"))), num<Word>(3)));
+        instructions.emplace_back(inc(mem(lea<Word>("ptr"))));
+    }
+    return program<Word>(std::move(instructions));
+}
+
+// make_workload in the text form read by ProgramStream
+void write_workload(const std::string& path, size_t mem_size) {
+    std::ofstream file(path, std::ios::trunc);
+    file << "data ptr num 1\n";
+    for (size_t i = 1; i < mem_size; i++) {
+        file << "mov mem num " << i << " num " << i << "\n";
+        file << "add mem num " << i << " mem num " << i - 1 << "\n";
+        file << "sub mem mem lea ptr num 3\n";
+        file << "inc mem lea ptr\n";
+    }
+}
+
+// Independent chains of arithmetic on disjoint cells, the shape of generated kernels that
+// dataflow-parallel execution is meant for.
+template <typename Word>
+program<Word> make_chains_workload(size_t mem_size) {
+    std::vector<InstructionPtr<Word>> instructions;
+    for (int round = 0; round < 4; round++) {
+        for (size_t i = 0; i < mem_size; i++) {
+            auto cell = static_cast<Word>(i);
+            instructions.emplace_back(add(mem(num<Word>(cell)), num<Word>(cell)));
+            instructions.emplace_back(sub(mem(num<Word>(cell)), num<Word>(round)));
+            instructions.emplace_back(ones(mem(num<Word>(cell))));
+        }
+    }
+    return program<Word>(std::move(instructions));
+}
+
+// The same initialization, copy and element-wise addition of two halves of the memory,
+// written cell by cell or with block instructions.
+template <typename Word>
+program<Word> make_scalar_block_workload(size_t mem_size) {
+    std::vector<InstructionPtr<Word>> instructions;
+    auto half = static_cast<Word>(mem_size / 2);
+    for (Word i = 0; i < half; i++)
+        instructions.emplace_back(mov(mem(num<Word>(i)), num<Word>(3)));
+    for (Word i = 0; i < half; i++)
+        instructions.emplace_back(mov(mem(num<Word>(half + i)), mem(num<Word>(i))));
+    for (Word i = 0; i < half; i++)
+        instructions.emplace_back(add(mem(num<Word>(half + i)), mem(num<Word>(i))));
+    return program<Word>(std::move(instructions));
+}
+
+template <typename Word>
+program<Word> make_vector_block_workload(size_t mem_size) {
+    auto half = static_cast<Word>(mem_size / 2);
+    return program<Word>({fill(num<Word>(0), num<Word>(3), num<Word>(half)),
+                          copy(num<Word>(half), num<Word>(0), num<Word>(half)),
+                          vadd(num<Word>(half), num<Word>(0), num<Word>(half))});
+}
+
+// Pointer chasing over a large memory: the input fills the memory with random addresses and
+// every instruction increments the cell whose address is held in another random cell, so
+// nearly every access misses the caches and, with small pages, the TLB.
+template <typename Word>
+program<Word> make_random_access_workload(size_t mem_size, size_t length,
+                                          BootInput<Word>& input) {
+    std::mt19937_64 random(42);
+    std::uniform_int_distribution<size_t> cell(0, mem_size - 1);
+    input.memory_image.resize(mem_size);
+    for (auto& address : input.memory_image)
+        address = static_cast<Word>(cell(random));
+    std::vector<InstructionPtr<Word>> instructions;
+    for (size_t i = 0; i < length; i++)
+        instructions.emplace_back(inc(mem(mem(num<Word>(static_cast<Word>(cell(random)))))));
+    return program<Word>(std::move(instructions));
+}
+
+template <typename Word>
+void run_placed(const char* name, const program<Word>& prog, const BootInput<Word>& input,
+                size_t mem_size, int repetitions, const MemoryPlacement& placement) {
+    std::unique_ptr<Storage<Word>> storage;
+    try {
+        storage = std::make_unique<PlacedStorage<Word>>(mem_size, placement);
+    }
+    catch (const std::exception& error) {
+        std::cout << name << ": unavailable (" << error.what() << ")\n";
+        return;
+    }
+    BasicComputer<Word> computer(std::move(storage));
+    BootProfile profile;
+    for (int i = 0; i < repetitions; i++)
+        computer.boot(prog, input, profile);
+
+    using ms = std::chrono::duration<double, std::milli>;
+    auto executed = profile.get_instructions_executed();
+    auto misses = profile.get(BootPhase::EXECUTION, HardwareEvent::DTLB_MISSES);
+    std::cout << name << ": memory " << mem_size * sizeof(Word) << " B, execution "
+              << ms(profile.get_time(BootPhase::EXECUTION)).count() / repetitions << " ms, "
+              << ms(profile.get_time(BootPhase::EXECUTION)).count() * 1e6 / executed
+              << " ns/instruction, dTLB misses/instruction ";
+    if (misses)
+        std::cout << static_cast<double>(*misses) / executed << "\n";
+    else
+        std::cout << "n/a\n";
+}
+
+// dump encodings of a memory whose cells past the first mem_size stay zero, after booting
+// the same program twice
+template <typename Word>
+void run_dumps(const program<Word>& prog, size_t mem_size, size_t used_cells) {
+    BasicComputer<Word> computer(mem_size);
+    computer.boot(prog);
+    auto previous = computer.memory_snapshot();
+    computer.boot(prog);
+
+    using ms = std::chrono::duration<double, std::milli>;
+    auto measure = [&](const char* name, auto&& dump) {
+        std::ostringstream stream;
+        auto start = std::chrono::steady_clock::now();
+        dump(stream);
+        auto end = std::chrono::steady_clock::now();
+        std::cout << name << ": memory " << mem_size * sizeof(Word) << " B, " << used_cells
+                  << " cells used, dump " << stream.str().size() << " B in "
+                  << ms(end - start).count() << " ms\n";
+    };
+    measure("classic dump", [&](std::ostream& stream) { computer.memory_dump(stream); });
+    measure("sparse dump", [&](std::ostream& stream) { computer.memory_dump_sparse(stream); });
+    measure("delta dump", [&](std::ostream& stream) {
+        computer.memory_dump_delta(stream, previous);
+    });
+}
+
+template <template <typename> class Program, typename Word>
+void run(const char* name, const Program<Word>& prog, size_t mem_size, int repetitions,
+         bool parallel = false) {
+    BasicComputer<Word> computer(mem_size);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        if constexpr (std::is_same_v<Program<Word>, program<Word>>) {
+            if (parallel) {
+                computer.boot_parallel(prog);
+                continue;
+            }
+        }
+        computer.boot(prog);
+    }
+    auto boot_end = std::chrono::steady_clock::now();
+    std::ostringstream dump;
+    computer.memory_dump(dump);
+    auto dump_end = std::chrono::steady_clock::now();
+
+    using ms = std::chrono::duration<double, std::milli>;
+    std::cout << name << ": memory " << mem_size * sizeof(Word) << " B, boot "
+              << ms(boot_end - start).count() / repetitions << " ms, dump "
+              << ms(dump_end - boot_end).count() << " ms\n";
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t mem_size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 16;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    auto workload32 = make_workload<int32_t>(mem_size);
+    run("int32", workload32, mem_size, repetitions);
+    auto workload64 = make_workload<int64_t>(mem_size);
+    run("int64", workload64, mem_size, repetitions);
+#ifdef __SIZEOF_INT128__
+    auto workload128 = make_workload<int128_t>(mem_size);
+    run("int128", workload128, mem_size, repetitions);
+#endif
+
+    // the same program decoded from a file while it runs
+    std::string path = "/tmp/ooasm_bench_" + std::to_string(getpid()) + ".ooasm";
+    write_workload(path, mem_size);
+    run("int64 streamed from file", ProgramStream<int64_t>(path), mem_size, repetitions);
+    std::remove(path.c_str());
+
+    auto scalar_blocks = make_scalar_block_workload<int64_t>(mem_size);
+    run("int64 fill/copy/add unrolled", scalar_blocks, mem_size, repetitions);
+    auto vector_blocks = make_vector_block_workload<int64_t>(mem_size);
+    run("int64 fill/copy/vadd blocks", vector_blocks, mem_size, repetitions);
+    auto vector_blocks32 = make_vector_block_workload<int32_t>(mem_size);
+    run("int32 fill/copy/vadd blocks", vector_blocks32, mem_size, repetitions);
+
+    auto chains = make_chains_workload<int64_t>(mem_size);
+    run("int64 chains sequential", chains, mem_size, repetitions);
+    run("int64 chains dataflow-parallel", chains, mem_size, repetitions, true);
+
+    // page size and NUMA placement of a memory 64 times larger
+    size_t random_mem_size = mem_size * 64;
+    BootInput<int64_t> random_input;
+    auto random_access = make_random_access_workload(random_mem_size, mem_size * 16, random_input);
+    for (auto [name, placement] : {
+             std::pair {"random access, 4K pages", MemoryPlacement {}},
+             std::pair {"random access, transparent huge pages",
+                        MemoryPlacement {PageSize::TRANSPARENT, NumaPolicy::DEFAULT, {}}},
+             std::pair {"random access, 2M pages",
+                        MemoryPlacement {PageSize::HUGE_2MB, NumaPolicy::DEFAULT, {}}},
+             std::pair {"random access, 1G pages",
+                        MemoryPlacement {PageSize::HUGE_1GB, NumaPolicy::DEFAULT, {}}},
+             std::pair {"random access, huge pages bound to node 0",
+                        MemoryPlacement {PageSize::TRANSPARENT, NumaPolicy::BIND, {0}}},
+             std::pair {"random access, huge pages interleaved",
+                        MemoryPlacement {PageSize::TRANSPARENT, NumaPolicy::INTERLEAVE, {0, 1}}},
+         })
+        run_placed(name, random_access, random_input, random_mem_size, repetitions, placement);
+
+    run_dumps(workload64, mem_size * 64, mem_size);
+
+    // hardware counters of the 64-bit workload, per boot phase
+    BootProfile profile;
+    Computer computer(mem_size);
+    for (int i = 0; i < repetitions; i++)
+        computer.boot(workload64, profile);
+    std::ostringstream dump;
+    computer.memory_dump(dump, profile);
+    profile.report(std::cout);
+}
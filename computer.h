@@ -1,34 +1,175 @@
 #ifndef JNP_6_COMPUTER_H
 #define JNP_6_COMPUTER_H
 
+#include "dataflow.h"
 #include "ooasm.h"
+#include "perf_counters.h"
+#include "program_stream.h"
+#include "result_cache.h"
 #include <iostream>
 #include <map>
+#include <thread>
 
-class Computer {
+// Input of a single boot. The memory starts from memory_image (zeros past its end) instead of
+// zeros, and the variables named in data_overrides are declared with the given values instead
+// of the ones in the program, so one program serves many inputs. Can be reused between boots.
+template <typename Word>
+struct BootInput {
+    std::vector<Word> memory_image;
+    typename Memory<Word>::Overrides data_overrides;
+};
+
+template <typename Word>
+class BasicComputer {
   public:
-    explicit Computer(size_t mem_size) : memory(mem_size), flags() {}
-    void boot(program& prog) {
-        memory.reset();
-        // variable declarations
-        while (prog.has_next_instruction()) {
-            const Instruction& instruction = prog.get_next_instruction();
-            instruction.pre_evaluate(memory);
+    explicit BasicComputer(size_t mem_size) : memory(mem_size), flags() {}
+    // memory kept in the given storage, e.g. a MappedStorage
+    explicit BasicComputer(std::unique_ptr<Storage<Word>> storage)
+        : memory(std::move(storage)), flags() {}
+    void boot(const program<Word>& prog) {
+        NoProfile profile;
+        run(prog, profile);
+    }
+    // boot on the given input; overriding a variable the program does not declare throws
+    // WrongVarNameException
+    void boot(const program<Word>& prog, const BootInput<Word>& input) {
+        NoProfile profile;
+        run(prog, profile, &input);
+    }
+    // Boot on the cells as they are instead of zeros, e.g. on the image of a previous run kept
+    // in a MappedStorage, without copying it. Declarations are written over the cells, as with
+    // BootInput.
+    void boot_in_place(const program<Word>& prog) {
+        NoProfile profile;
+        run(prog, profile, nullptr, true);
+    }
+    // boot with hardware counters and time of every phase accumulated in profile
+    void boot(const program<Word>& prog, BootProfile& profile) {
+        run(prog, profile);
+    }
+    void boot(const program<Word>& prog, const BootInput<Word>& input, BootProfile& profile) {
+        run(prog, profile, &input);
+    }
+    // boot a program decoded from a file while it runs, in two passes over the file
+    void boot(const ProgramStream<Word>& prog) {
+        NoProfile profile;
+        run(prog, profile);
+    }
+    void boot(const ProgramStream<Word>& prog, BootProfile& profile) {
+        run(prog, profile);
+    }
+    // Same result as boot, but the outcome of a program already booted with the same memory
+    // size and flags is taken from the cache instead of being computed again.
+    void boot(const program<Word>& prog, ResultCache<Word>& cache) {
+        BootKey key {prog.content_hash(), memory.size(), flags.is_zero(), flags.is_signed()};
+        if (auto outcome = cache.find(key)) {
+            memory.restore(outcome->memory_image);
+            flags = Flags<Word>(outcome->zero, outcome->sign);
+            if (outcome->error != BootError::NONE)
+                throw_boot_error(outcome->error);
+            return;
+        }
+        try {
+            boot(prog);
         }
-        prog.go_to_start();
-        // executing program
-        while (prog.has_next_instruction()) {
-            const Instruction& instruction = prog.get_next_instruction();
-            instruction.evaluate(memory, flags);
+        catch (...) {
+            if (auto error = classify_boot_error(std::current_exception()))
+                cache.insert(key, current_outcome(*error));
+            throw;
         }
+        cache.insert(key, current_outcome(BootError::NONE));
+    }
+    // Same result as boot, but independent parts of the program are executed on up to
+    // `threads` threads (see DataflowPlan).
+    void boot_parallel(const program<Word>& prog,
+                       unsigned threads = std::thread::hardware_concurrency()) {
+        if (threads <= 1)
+            return boot(prog);
+        memory.reset();
+        declare_variables(prog);
+        typename DataflowPlan<Word>::InstructionList instructions;
+        for (auto cursor = prog.start(); cursor.has_next_instruction();)
+            instructions.push_back(&cursor.get_next_instruction());
+        DataflowPlan<Word>(instructions, memory, threads).execute(memory, flags);
     }
     void memory_dump(std::ostream& stream) const {
         memory.dump(stream);
     }
+    void memory_dump(std::ostream& stream, BootProfile& profile) const {
+        profile.measure(BootPhase::DUMP, [&] { memory.dump(stream); });
+    }
+    // Only the non-zero cells, as runs of equal values (see Memory::dump_delta). decode_dump
+    // and write_dump (dump_decoder.h) turn it back into the text of memory_dump.
+    void memory_dump_sparse(std::ostream& stream) const {
+        memory.dump_delta(stream, {});
+    }
+    // only the cells differing from base, e.g. a memory_snapshot taken after the previous run
+    void memory_dump_delta(std::ostream& stream, const std::vector<Word>& base) const {
+        memory.dump_delta(stream, base);
+    }
+    std::vector<Word> memory_snapshot() const {
+        return memory.snapshot();
+    }
+    // makes the current memory durable when it is backed by a file
+    void checkpoint() {
+        memory.sync();
+    }
 
   private:
-    Memory memory;
-    Flags flags;
+    // Program is a program or a ProgramStream
+    template <typename Program, typename Profile>
+    void run(const Program& prog, Profile& profile, const BootInput<Word>* input = nullptr,
+             bool keep_cells = false) {
+        profile.measure(BootPhase::RESET, [&] {
+            if (keep_cells)
+                memory.reset_keeping_cells();
+            else if (input != nullptr)
+                memory.reset(input->memory_image);
+            else
+                memory.reset();
+        });
+        profile.measure(BootPhase::DECLARATION, [&] {
+            declare_variables(prog, input != nullptr ? &input->data_overrides : nullptr);
+        });
+        uint64_t executed = 0;
+        profile.measure(BootPhase::EXECUTION, [&] {
+            for (auto cursor = prog.start(); cursor.has_next_instruction();) {
+                const Instruction<Word>& instruction = cursor.get_next_instruction();
+                instruction.evaluate(memory, flags);
+                executed++;
+            }
+        });
+        profile.count_instructions(executed);
+    }
+
+    BootOutcome<Word> current_outcome(BootError error) const {
+        return BootOutcome<Word> {memory.snapshot(), flags.is_zero(), flags.is_signed(), error};
+    }
+
+    template <typename Program>
+    void declare_variables(const Program& prog,
+                           const typename Memory<Word>::Overrides* overrides = nullptr) {
+        memory.override_declarations(overrides);
+        for (auto cursor = prog.start(); cursor.has_next_instruction();) {
+            const Instruction<Word>& instruction = cursor.get_next_instruction();
+            instruction.pre_evaluate(memory);
+        }
+        memory.override_declarations(nullptr);
+        if (overrides != nullptr) {
+            for (const auto& overridden : *overrides)
+                if (!memory.is_declared(overridden.first))
+                    throw WrongVarNameException();
+        }
+    }
+
+    Memory<Word> memory;
+    Flags<Word> flags;
 };
 
+using Computer = BasicComputer<int64_t>;
+using Computer32 = BasicComputer<int32_t>;
+#ifdef __SIZEOF_INT128__
+using Computer128 = BasicComputer<int128_t>;
+#endif
+
 #endif // JNP_6_COMPUTER_H
@@ -0,0 +1,209 @@
+#ifndef JNP_6_DATAFLOW_H
+#define JNP_6_DATAFLOW_H
+
+#include "ooasm.h"
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Parallel execution plan of a straight-line program, built once its variables are declared.
+// Instructions whose footprint is static are grouped into connected components: two
+// instructions are connected if they touch the same cell or register, or if one reads the flags
+// last written by the other. Components share no cell nor register, so they are spread over
+// lanes executed on separate threads, each component keeping the program order of its
+// instructions and working on its own copy of the flags the stage started with; the flags left
+// by the component holding the last flag-writing instruction become the flags of the computer.
+// Instructions with a dynamic footprint (e.g. mem(mem(...))) act as barriers and are executed
+// sequentially between the parallel stages, which keeps the final memory image and flags
+// identical to sequential execution.
+template <typename Word>
+class DataflowPlan {
+  public:
+    using InstructionList = std::vector<const Instruction<Word>*>;
+
+    // segments shorter than that are not worth starting threads for
+    const static size_t MIN_PARALLEL_SEGMENT = 1024;
+
+    DataflowPlan(const InstructionList& instructions, const Memory<Word>& memory,
+                 unsigned max_lanes)
+        : max_lanes(std::max(max_lanes, 1u)) {
+        Footprint<Word> footprint;
+        for (auto instruction : instructions) {
+            footprint.clear();
+            instruction->collect_footprint(memory, footprint);
+            if (footprint.is_dynamic()) {
+                close_segment();
+                append_sequential(instruction);
+            }
+            else
+                append_to_segment(instruction, footprint);
+        }
+        close_segment();
+    }
+
+    void execute(Memory<Word>& memory, Flags<Word>& flags) const {
+        for (const auto& stage : stages) {
+            if (stage.lanes.size() == 1 && stage.lanes.front().size() == 1) {
+                run_component(stage.lanes.front().front(), memory, flags);
+                continue;
+            }
+            // only the lane holding the flags component writes the published flags
+            Flags<Word> published = flags;
+            std::vector<std::exception_ptr> errors(stage.lanes.size());
+            std::vector<std::thread> workers;
+            auto run = [&](size_t i) {
+                errors[i] = run_guarded(stage, i, memory, flags, published);
+            };
+            for (size_t i = 1; i < stage.lanes.size(); i++)
+                workers.emplace_back(run, i);
+            run(0);
+            for (auto& worker : workers)
+                worker.join();
+            for (const auto& error : errors)
+                if (error)
+                    std::rethrow_exception(error);
+            flags = published;
+        }
+    }
+
+  private:
+    // components executed one after another; they share nothing, so their order does not matter
+    using Lane = std::vector<InstructionList>;
+
+    struct Stage {
+        std::vector<Lane> lanes; // executed concurrently
+        // lane and position in it of the component writing the flags last, if any
+        std::optional<std::pair<size_t, size_t>> flags_component;
+    };
+
+    static void run_component(const InstructionList& component, Memory<Word>& memory,
+                              Flags<Word>& flags) {
+        for (auto instruction : component)
+            instruction->evaluate(memory, flags);
+    }
+
+    static std::exception_ptr run_guarded(const Stage& stage, size_t lane, Memory<Word>& memory,
+                                          const Flags<Word>& incoming,
+                                          Flags<Word>& published) noexcept {
+        try {
+            const auto& components = stage.lanes[lane];
+            for (size_t i = 0; i < components.size(); i++) {
+                Flags<Word> flags = incoming;
+                run_component(components[i], memory, flags);
+                if (stage.flags_component == std::make_pair(lane, i))
+                    published = flags;
+            }
+        }
+        catch (...) {
+            return std::current_exception();
+        }
+        return nullptr;
+    }
+
+    size_t find(size_t i) {
+        while (parent[i] != i)
+            i = parent[i] = parent[parent[i]];
+        return i;
+    }
+
+    void unite(size_t i, size_t j) {
+        parent[find(i)] = find(j);
+    }
+
+    void append_to_segment(const Instruction<Word>* instruction, const Footprint<Word>& footprint) {
+        size_t index = segment.size();
+        segment.push_back(instruction);
+        parent.push_back(index);
+        for (auto address : footprint.get_cells()) {
+            auto it = cell_owners.try_emplace(static_cast<size_t>(address), index).first;
+            unite(index, it->second);
+        }
+        for (auto index_of_register : footprint.get_registers()) {
+            auto& owner = register_owners[index_of_register];
+            if (!owner)
+                owner = index;
+            unite(index, *owner);
+        }
+        if (footprint.reads_flags() && last_flags_writer)
+            unite(index, *last_flags_writer);
+        if (footprint.writes_flags())
+            last_flags_writer = index;
+    }
+
+    void close_segment() {
+        if (segment.size() < MIN_PARALLEL_SEGMENT || max_lanes == 1) {
+            for (auto instruction : segment)
+                append_sequential(instruction);
+        }
+        else
+            append_parallel();
+        segment.clear();
+        parent.clear();
+        cell_owners.clear();
+        register_owners.fill(std::nullopt);
+        last_flags_writer.reset();
+    }
+
+    void append_parallel() {
+        std::vector<InstructionList> components;
+        std::unordered_map<size_t, size_t> component_of_root;
+        for (size_t i = 0; i < segment.size(); i++) {
+            auto it = component_of_root.try_emplace(find(i), components.size()).first;
+            if (it->second == components.size())
+                components.emplace_back();
+            components[it->second].push_back(segment[i]);
+        }
+        if (components.size() == 1) {
+            for (auto instruction : segment)
+                append_sequential(instruction);
+            return;
+        }
+        std::optional<size_t> flags_component;
+        if (last_flags_writer)
+            flags_component = component_of_root[find(*last_flags_writer)];
+
+        // largest components first, each one to the least loaded lane
+        std::vector<size_t> order(components.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return components[a].size() > components[b].size();
+        });
+        Stage stage;
+        stage.lanes.resize(std::min<size_t>(max_lanes, components.size()));
+        std::vector<size_t> lane_sizes(stage.lanes.size(), 0);
+        for (auto component : order) {
+            size_t lane = std::min_element(lane_sizes.begin(), lane_sizes.end()) -
+                          lane_sizes.begin();
+            lane_sizes[lane] += components[component].size();
+            if (component == flags_component)
+                stage.flags_component = std::make_pair(lane, stage.lanes[lane].size());
+            stage.lanes[lane].push_back(std::move(components[component]));
+        }
+        stages.push_back(std::move(stage));
+    }
+
+    void append_sequential(const Instruction<Word>* instruction) {
+        if (stages.empty() || stages.back().lanes.size() != 1 ||
+            stages.back().lanes.front().size() != 1)
+            stages.push_back(Stage {std::vector<Lane>(1, Lane(1)), std::nullopt});
+        stages.back().lanes.front().front().push_back(instruction);
+    }
+
+    unsigned max_lanes;
+    std::vector<Stage> stages;
+
+    // state of the segment of static instructions being partitioned
+    InstructionList segment;
+    std::vector<size_t> parent;
+    std::unordered_map<size_t, size_t> cell_owners;
+    std::array<std::optional<size_t>, REGISTER_COUNT> register_owners;
+    std::optional<size_t> last_flags_writer;
+};
+
+#endif // JNP_6_DATAFLOW_H
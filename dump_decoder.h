@@ -0,0 +1,67 @@
+#ifndef JNP_6_DUMP_DECODER_H
+#define JNP_6_DUMP_DECODER_H
+
+#include "ooasm.h"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class DumpFormatException : public std::exception {
+  public:
+    const char* what() const noexcept override {
+        return "Invalid memory dump!";
+    }
+};
+
+// dumps of larger memories are rejected unless decode_dump is given a larger limit
+const static size_t DEFAULT_MAX_DUMP_CELLS = size_t(1) << 32;
+
+// non-negative decimal number of a dump, or nothing at the end of the input
+inline std::optional<size_t> read_dump_number(std::istream& input) {
+    std::string text;
+    if (!(input >> text))
+        return std::nullopt;
+    auto number = parse_word<int64_t>(text);
+    if (!number || *number < 0)
+        throw DumpFormatException();
+    return static_cast<size_t>(*number);
+}
+
+// Cells of a dump written by Memory::dump_delta against the same base (empty for sparse dumps),
+// so a series of delta dumps is decoded by passing every decoded image as the next base.
+template <typename Word>
+std::vector<Word> decode_dump(std::istream& input, const std::vector<Word>& base = {},
+                              size_t max_cells = DEFAULT_MAX_DUMP_CELLS) {
+    auto memory_size = read_dump_number(input);
+    if (!memory_size || *memory_size > max_cells)
+        throw DumpFormatException();
+    std::vector<Word> image(*memory_size, 0);
+    std::copy_n(base.begin(), std::min(base.size(), *memory_size), image.begin());
+
+    std::string value;
+    while (auto address = read_dump_number(input)) {
+        auto count = read_dump_number(input);
+        if (!count || !(input >> value) || *address > *memory_size ||
+            *count > *memory_size - *address || *count == 0)
+            throw DumpFormatException();
+        auto word = parse_word<Word>(value);
+        if (!word)
+            throw DumpFormatException();
+        std::fill_n(image.begin() + *address, *count, *word);
+    }
+    if (!input.eof())
+        throw DumpFormatException();
+    return image;
+}
+
+// the classic text form written by Memory::dump
+template <typename Word>
+void write_dump(std::ostream& stream, const std::vector<Word>& image) {
+    for (auto word : image) {
+        WordTraits<Word>::print(stream, word);
+        stream << " ";
+    }
+}
+
+#endif // JNP_6_DUMP_DECODER_H
@@ -0,0 +1,89 @@
+#ifndef JNP_6_MAPPED_STORAGE_H
+#define JNP_6_MAPPED_STORAGE_H
+
+#include "ooasm.h"
+#include <cerrno>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class ImageSizeMismatchException : public std::exception {
+  public:
+    const char* what() const noexcept override {
+        return "Existing memory image does not match the requested memory size!";
+    }
+};
+
+// Memory cells kept in a file mapped with MAP_SHARED. The file is the raw array of mem_size
+// words in native byte order, with no header, so other processes can map it and read the
+// final state of a run directly, without memory_dump. A new or empty file is extended to the
+// right size (filled with zeros); an existing image of the same size is mapped as it is, so
+// a computer can dump it, or continue from it with boot_in_place (boot zeroes the cells first).
+// sync() flushes the pages to the file, which makes a checkpoint of the current memory.
+template <typename Word>
+class MappedStorage : public Storage<Word> {
+  public:
+    MappedStorage(const std::string& path, size_t mem_size) : memory_size(mem_size) {
+        fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        try {
+            map_file();
+        }
+        catch (...) {
+            close(fd);
+            throw;
+        }
+    }
+    MappedStorage(const MappedStorage&) = delete;
+    MappedStorage& operator=(const MappedStorage&) = delete;
+    ~MappedStorage() override {
+        if (memory_array != nullptr)
+            munmap(memory_array, bytes());
+        close(fd);
+    }
+
+    Word* cells() noexcept override {
+        return memory_array;
+    }
+    size_t size() const noexcept override {
+        return memory_size;
+    }
+    void sync() override {
+        if (memory_array != nullptr && msync(memory_array, bytes(), MS_SYNC) != 0)
+            throw std::system_error(errno, std::generic_category(), "msync");
+    }
+
+  private:
+    size_t bytes() const noexcept {
+        return memory_size * sizeof(Word);
+    }
+
+    void map_file() {
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0)
+            throw std::system_error(errno, std::generic_category(), "fstat");
+        auto file_size = static_cast<size_t>(file_stat.st_size);
+        if (file_size == 0 && ftruncate(fd, static_cast<off_t>(bytes())) != 0)
+            throw std::system_error(errno, std::generic_category(), "ftruncate");
+        else if (file_size != 0 && file_size != bytes())
+            throw ImageSizeMismatchException();
+
+        if (memory_size == 0) // mmap of zero bytes is not allowed
+            return;
+        void* address = mmap(nullptr, bytes(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        memory_array = static_cast<Word*>(address);
+    }
+
+    size_t memory_size;
+    int fd = -1;
+    Word* memory_array = nullptr;
+};
+
+#endif // JNP_6_MAPPED_STORAGE_H
@@ -1,27 +1,138 @@
 #ifndef JNP_6_OOASM_H
 #define JNP_6_OOASM_H
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <variant>
 #include <unordered_map>
 #include <vector>
 
 const static size_t MAX_ID_LENGTH = 10;
+const static size_t REGISTER_COUNT = 16;
 
 // conversion from const char* to std::string, avoiding copying very long identifiers
-static std::string convert_to_string(const char* text) {
+inline std::string convert_to_string(const char* text) {
     if (text == nullptr) {
         return "";
     }
-    for (int i = 0; i <= MAX_ID_LENGTH; i++) {
+    for (size_t i = 0; i <= MAX_ID_LENGTH; i++) {
         if (text[i] == '\0')
             return std::string(text);
     }
     return std::string(text, text + MAX_ID_LENGTH + 1);
 }
 
+// Word-size dependent properties of the simulated machine: the unsigned type used for
+// addressing and the textual format used by memory_dump.
+template <typename Word>
+struct WordTraits {
+    static_assert(std::is_signed_v<Word>, "OOAsm word has to be a signed integer type");
+    using Address = std::make_unsigned_t<Word>;
+
+    static void print(std::ostream& stream, Word word) {
+        stream << word;
+    }
+};
+
+#ifdef __SIZEOF_INT128__
+using int128_t = __int128;
+
+// std::ostream has no operator<< for 128-bit integers, so the digits are formatted by hand.
+template <>
+struct WordTraits<int128_t> {
+    using Address = unsigned __int128;
+
+    static void print(std::ostream& stream, int128_t word) {
+        char buffer[41];
+        char* const end = buffer + sizeof(buffer);
+        char* begin = end;
+        Address magnitude = word < 0 ? -static_cast<Address>(word) : static_cast<Address>(word);
+        do {
+            *--begin = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (word < 0)
+            *--begin = '-';
+        stream.write(begin, end - begin);
+    }
+};
+#endif
+
+// Inverse of WordTraits::print: a decimal number, or nothing if the text is not one or does not
+// fit in a Word. Digits are read by hand, since streams cannot read 128-bit integers.
+template <typename Word>
+std::optional<Word> parse_word(std::string_view text) {
+    using Address = typename WordTraits<Word>::Address;
+    bool negative = !text.empty() && text[0] == '-';
+    size_t first_digit = negative ? 1 : 0;
+    if (first_digit == text.size())
+        return std::nullopt;
+    const Address max_magnitude = (~Address(0) >> 1) + (negative ? 1 : 0);
+    Address magnitude = 0;
+    for (size_t i = first_digit; i < text.size(); i++) {
+        if (text[i] < '0' || text[i] > '9')
+            return std::nullopt;
+        Address digit = text[i] - '0';
+        if (magnitude > (max_magnitude - digit) / 10)
+            return std::nullopt;
+        magnitude = magnitude * 10 + digit;
+    }
+    return static_cast<Word>(negative ? -magnitude : magnitude);
+}
+
+// 128-bit digest of the contents of a program.
+struct ProgramHash {
+    uint64_t high = 0, low = 0;
+
+    bool operator==(const ProgramHash& other) const noexcept {
+        return high == other.high && low == other.low;
+    }
+};
+
+// Content hash of programs, stable between runs and hosts: everything is fed byte by byte,
+// words in little-endian order, into two independent FNV-1a style lanes finished with a
+// splitmix64 mix.
+class ProgramHasher {
+  public:
+    void add_byte(uint8_t byte) noexcept {
+        low = (low ^ byte) * 0x100000001b3ULL;
+        high = (high ^ byte) * 0x9e3779b97f4a7c15ULL;
+    }
+    template <typename Word>
+    void add_word(Word word) noexcept {
+        auto bits = static_cast<typename WordTraits<Word>::Address>(word);
+        for (size_t i = 0; i < sizeof(Word); i++, bits >>= 8)
+            add_byte(static_cast<uint8_t>(bits & 0xff));
+    }
+    void add_text(const std::string& text) noexcept {
+        add_word<int64_t>(static_cast<int64_t>(text.size()));
+        for (char c : text)
+            add_byte(static_cast<uint8_t>(c));
+    }
+    ProgramHash digest() const noexcept {
+        return ProgramHash {mix(high), mix(low ^ high)};
+    }
+
+  private:
+    static uint64_t mix(uint64_t x) noexcept {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    uint64_t low = 0xcbf29ce484222325ULL;
+    uint64_t high = 0x84222325cbf29ce4ULL;
+};
+
 class EndOfProgramException : public std::exception {
   public:
     const char* what() const noexcept override {
@@ -57,61 +168,197 @@ class InvalidIdentifierException : public std::exception {
     }
 };
 
+class InvalidRegisterException : public std::exception {
+  public:
+    const char* what() const noexcept override {
+        return "Register with given number does not exist!";
+    }
+};
+
+// Place where the memory cells live. The cells do not move for the lifetime of the storage.
+template <typename Word>
+class Storage {
+  public:
+    virtual Word* cells() noexcept = 0;
+    virtual size_t size() const noexcept = 0;
+    // makes the current contents durable, if the storage is backed by anything durable
+    virtual void sync() {}
+    virtual ~Storage() = default;
+};
+
+template <typename Word>
+class VectorStorage : public Storage<Word> {
+  public:
+    explicit VectorStorage(size_t mem_size) : memory_array(mem_size, 0) {}
+    Word* cells() noexcept override {
+        return memory_array.data();
+    }
+    size_t size() const noexcept override {
+        return memory_array.size();
+    }
+
+  private:
+    std::vector<Word> memory_array;
+};
+
+template <typename Word>
 class Memory {
   private:
-    void validate_address(int64_t address) const {
-        if (address < 0 || address >= memory_array.size())
+    using Address = typename WordTraits<Word>::Address;
+
+    void validate_address(Word address) const {
+        if (!contains(address))
             throw OutOfBoundsException();
     }
 
   public:
-    Memory(size_t mem_size) : memory_array(mem_size, 0), var_addresses() {}
-    void declare_variable(const std::string& id, int64_t value) {
+    Memory(size_t mem_size) : Memory(std::make_unique<VectorStorage<Word>>(mem_size)) {}
+    Memory(std::unique_ptr<Storage<Word>> storage_ptr)
+        : storage(std::move(storage_ptr)), memory_array(storage->cells()),
+          memory_size(storage->size()), var_addresses() {}
+    using Overrides = std::unordered_map<std::string, Word>;
+
+    void declare_variable(const std::string& id, Word value) {
         if (id.empty() || id.length() > MAX_ID_LENGTH)
             throw InvalidIdentifierException();
-        if (next_address >= memory_array.size())
+        if (next_address >= memory_size)
             throw MemoryOverflowException();
+        if (overrides != nullptr) {
+            auto it = overrides->find(id);
+            if (it != overrides->end())
+                value = it->second;
+        }
 
         memory_array[next_address] = value;
         var_addresses.insert({id, next_address++});
     }
-    int64_t get_address(const std::string& id) const{
+    Word get_address(const std::string& id) const {
         auto it = var_addresses.find(id);
         if (it == var_addresses.end())
             throw WrongVarNameException();
 
-        return it->second;
+        return static_cast<Word>(it->second);
+    }
+    bool is_declared(const std::string& id) const {
+        return var_addresses.count(id) != 0;
     }
-    int64_t get_value(int64_t address) const {
+    bool contains(Word address) const noexcept {
+        return address >= 0 && static_cast<Address>(address) < memory_size;
+    }
+    Word get_value(Word address) const {
         validate_address(address);
-        return memory_array[address];
+        return memory_array[static_cast<Address>(address)];
     }
-    void set_variable(int64_t address, int64_t value) {
+    void set_variable(Word address, Word value) {
         validate_address(address);
-        memory_array[address] = value;
+        memory_array[static_cast<Address>(address)] = value;
+    }
+    Word& at(Word address) {
+        validate_address(address);
+        return memory_array[static_cast<Address>(address)];
+    }
+    // first of count consecutive cells, all of them checked at once
+    Word* block(Word address, Word count) {
+        if (address < 0 || count < 0 || static_cast<Address>(address) > memory_size ||
+            static_cast<Address>(count) > memory_size - static_cast<Address>(address))
+            throw OutOfBoundsException();
+        return memory_array + static_cast<Address>(address);
+    }
+    // Registers are kept next to the cells, but they have no addresses and are not dumped.
+    // The index is checked when the register operand is created.
+    Word& register_at(size_t index) noexcept {
+        return registers[index];
     }
     void dump(std::ostream& stream) const {
-        for (auto i : memory_array)
-            stream << i << " ";
+        for (size_t i = 0; i < memory_size; i++) {
+            WordTraits<Word>::print(stream, memory_array[i]);
+            stream << " ";
+        }
+    }
+    // Cells differing from base (cells past its end count as zeros) as runs of equal values: a
+    // line with the number of cells, then an "address count value" line per run. With an empty
+    // base it lists the non-zero cells only. decode_dump (dump_decoder.h) rebuilds the cells.
+    void dump_delta(std::ostream& stream, const std::vector<Word>& base) const {
+        const size_t common = std::min(memory_size, base.size());
+        auto base_at = [&](size_t i) { return i < common ? base[i] : Word(0); };
+        auto next_change = [&](size_t i) -> size_t {
+            if (i < common) {
+                i = std::mismatch(memory_array + i, memory_array + common, base.begin() + i)
+                        .first -
+                    memory_array;
+                if (i < common)
+                    return i;
+            }
+            return std::find_if(memory_array + i, memory_array + memory_size,
+                                [](Word word) { return word != 0; }) -
+                   memory_array;
+        };
+        stream << memory_size << "\n";
+        for (size_t i = next_change(0); i < memory_size; i = next_change(i)) {
+            size_t begin = i;
+            Word value = memory_array[i];
+            while (++i < memory_size && memory_array[i] == value && value != base_at(i)) {}
+            stream << begin << " " << i - begin << " ";
+            WordTraits<Word>::print(stream, value);
+            stream << "\n";
+        }
     }
     void reset() {
-        for (auto& i : memory_array)
-            i = 0;
+        std::fill(memory_array, memory_array + memory_size, 0);
+        reset_keeping_cells();
+    }
+    // like reset, but the cells keep their contents, e.g. an image mapped from a file
+    void reset_keeping_cells() noexcept {
+        registers.fill(0);
         var_addresses.clear();
         next_address = 0;
+        overrides = nullptr;
+    }
+    // like reset, but the cells start from the given image (zeros past its end)
+    void reset(const std::vector<Word>& image) {
+        if (image.size() > memory_size)
+            throw MemoryOverflowException();
+        reset();
+        std::copy(image.begin(), image.end(), memory_array);
+    }
+    // values declared instead of the ones given in the program, for the variables named in
+    // overrides, until the next reset
+    void override_declarations(const Overrides* declaration_overrides) noexcept {
+        overrides = declaration_overrides;
+    }
+    void sync() {
+        storage->sync();
+    }
+    std::vector<Word> snapshot() const {
+        return std::vector<Word>(memory_array, memory_array + memory_size);
+    }
+    // brings back the cells saved with snapshot, as they were at the end of that run
+    void restore(const std::vector<Word>& image) {
+        std::copy_n(image.begin(), std::min(image.size(), memory_size), memory_array);
+        reset_keeping_cells();
+    }
+    size_t size() const noexcept {
+        return memory_size;
     }
 
   private:
-    std::vector<int64_t> memory_array;
-    std::unordered_map<std::string, size_t> var_addresses;
-    size_t next_address = 0;
+    std::unique_ptr<Storage<Word>> storage;
+    Word* memory_array;
+    size_t memory_size;
+    std::array<Word, REGISTER_COUNT> registers {};
+    std::unordered_map<std::string, Address> var_addresses;
+    Address next_address = 0;
+    const Overrides* overrides = nullptr;
 };
 
+template <typename Word>
 class Flags {
     bool ZF = false, SF = false;
 
   public:
-    void set(int64_t result) {
+    Flags() = default;
+    Flags(bool zero, bool sign) : ZF(zero), SF(sign) {}
+    void set(Word result) {
         ZF = result == 0;
         SF = result < 0;
     }
@@ -123,220 +370,695 @@ class Flags {
     }
 };
 
+// Memory cells and flags an instruction touches during execution, as far as they are known
+// once the variables are declared. Any access whose address is computed at run time, or which
+// would fail, makes the footprint dynamic.
+template <typename Word>
+class Footprint {
+  public:
+    void add_cell(Word address) {
+        cells.push_back(address);
+    }
+    void add_register(size_t index) {
+        registers.push_back(index);
+    }
+    void read_flags() noexcept {
+        flags_read = true;
+    }
+    void write_flags() noexcept {
+        flags_written = true;
+    }
+    void make_dynamic() noexcept {
+        dynamic = true;
+    }
+    const std::vector<Word>& get_cells() const noexcept {
+        return cells;
+    }
+    const std::vector<size_t>& get_registers() const noexcept {
+        return registers;
+    }
+    bool reads_flags() const noexcept {
+        return flags_read;
+    }
+    bool writes_flags() const noexcept {
+        return flags_written;
+    }
+    bool is_dynamic() const noexcept {
+        return dynamic;
+    }
+    void clear() noexcept {
+        cells.clear();
+        registers.clear();
+        flags_read = flags_written = dynamic = false;
+    }
+
+  private:
+    std::vector<Word> cells;
+    std::vector<size_t> registers;
+    bool flags_read = false, flags_written = false, dynamic = false;
+};
+
+template <typename Word>
+class RValue;
+
+// Operand modes. Instructions translate their operands into these plain descriptions once,
+// when they are constructed, and dispatch on the pair of modes with a single std::visit, instead
+// of walking the operand tree with a virtual call per node on every execution.
+template <typename Word>
+struct ImmediateMode { // num(value)
+    Word value;
+};
+
+template <typename Word>
+struct LabelMode { // lea(id)
+    const std::string* id;
+};
+
+template <typename Word>
+struct DirectMode { // mem(num(address))
+    Word address;
+};
+
+template <typename Word>
+struct LabelledMode { // mem(lea(id))
+    const std::string* id;
+};
+
+template <typename Word>
+struct IndirectMode { // mem(address) for any other address, e.g. mem(mem(...))
+    const RValue<Word>* address;
+};
+
+template <typename Word>
+struct RegisterMode { // reg(index)
+    size_t index;
+};
+
+template <typename Word>
+using SourceMode = std::variant<ImmediateMode<Word>, LabelMode<Word>, DirectMode<Word>,
+                                LabelledMode<Word>, IndirectMode<Word>, RegisterMode<Word>>;
+
+template <typename Word>
+using DestinationMode = std::variant<DirectMode<Word>, LabelledMode<Word>, IndirectMode<Word>,
+                                     RegisterMode<Word>>;
+
+template <typename Word>
+Word read(const ImmediateMode<Word>& mode, Memory<Word>&) {
+    return mode.value;
+}
+
+template <typename Word>
+Word read(const LabelMode<Word>& mode, Memory<Word>& memory) {
+    return memory.get_address(*mode.id);
+}
+
+// the cell or register an l-value mode refers to, checked once for both reading and writing
+template <typename Word>
+Word& location(const DirectMode<Word>& mode, Memory<Word>& memory) {
+    return memory.at(mode.address);
+}
+
+template <typename Word>
+Word& location(const LabelledMode<Word>& mode, Memory<Word>& memory) {
+    return memory.at(memory.get_address(*mode.id));
+}
+
+template <typename Word>
+Word& location(const IndirectMode<Word>& mode, Memory<Word>& memory);
+
+template <typename Word>
+Word& location(const RegisterMode<Word>& mode, Memory<Word>& memory) {
+    return memory.register_at(mode.index);
+}
+
+template <typename Mode, typename Word>
+auto read(const Mode& mode, Memory<Word>& memory)
+    -> std::remove_reference_t<decltype(location(mode, memory))> {
+    return location(mode, memory);
+}
+
+template <typename Word>
 class RValue {
   public:
-    virtual int64_t value(Memory& memory) const noexcept = 0;
+    using word_type = Word;
+    virtual Word value(Memory<Word>& memory) const = 0;
+    virtual SourceMode<Word> source_mode() const = 0;
+    // value of the operand if it does not depend on the contents of the memory
+    virtual std::optional<Word> static_value(const Memory<Word>& memory) const = 0;
+    virtual void collect_footprint(const Memory<Word>& memory, Footprint<Word>& footprint) const = 0;
+    virtual void hash(ProgramHasher& hasher) const = 0;
     virtual ~RValue() = default;
 };
 
-class LValue : public RValue {
+template <typename Word>
+Word& location(const IndirectMode<Word>& mode, Memory<Word>& memory) {
+    return memory.at(mode.address->value(memory));
+}
+
+template <typename Word>
+class LValue : public RValue<Word> {
   public:
-    virtual int64_t get_address(Memory& memory) const = 0;
+    virtual DestinationMode<Word> destination_mode() const = 0;
     virtual ~LValue() = default;
 };
 
-class Num : public RValue {
+template <typename Word>
+class Num : public RValue<Word> {
   public:
-    Num(int64_t value) : m_value(value) {}
-    int64_t value(Memory& memory) const noexcept override {
+    Num(Word value) : m_value(value) {}
+    Word value(Memory<Word>&) const override {
+        return m_value;
+    }
+    SourceMode<Word> source_mode() const override {
+        return ImmediateMode<Word> {m_value};
+    }
+    std::optional<Word> static_value(const Memory<Word>&) const override {
         return m_value;
     }
+    void collect_footprint(const Memory<Word>&, Footprint<Word>&) const override {}
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("num");
+        hasher.add_word(m_value);
+    }
   private:
-    const int64_t m_value;
+    const Word m_value;
 };
 
-std::unique_ptr<Num> num(int64_t value) {
-    return std::make_unique<Num>(value);
+// The word type cannot be deduced from the literal (num(1) would become a 32-bit int),
+// so it is given explicitly for non-default word sizes, e.g. num<int32_t>(1).
+template <typename Word = int64_t>
+std::unique_ptr<Num<Word>> num(typename RValue<Word>::word_type value) {
+    return std::make_unique<Num<Word>>(value);
 }
 
 
-class Lea : public RValue {
+template <typename Word>
+class Lea : public RValue<Word> {
     std::string id;
     Lea(std::string&& text) : id(text) {}
 
   public:
     explicit Lea(const char* text) : id(convert_to_string(text)) {}
-    int64_t value(Memory& memory) const noexcept override {
+    Word value(Memory<Word>& memory) const override {
+        return memory.get_address(id);
+    }
+    SourceMode<Word> source_mode() const override {
+        return LabelMode<Word> {&id};
+    }
+    std::optional<Word> static_value(const Memory<Word>& memory) const override {
+        if (!memory.is_declared(id))
+            return std::nullopt;
         return memory.get_address(id);
     }
+    void collect_footprint(const Memory<Word>& memory, Footprint<Word>& footprint) const override {
+        if (!memory.is_declared(id))
+            footprint.make_dynamic();
+    }
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("lea");
+        hasher.add_text(id);
+    }
 };
 
-std::unique_ptr<Lea> lea(const char* text) {
-    return std::make_unique<Lea>(text);
+template <typename Word = int64_t>
+std::unique_ptr<Lea<Word>> lea(const char* text) {
+    return std::make_unique<Lea<Word>>(text);
 }
 
-class Mem : public LValue {
-    std::unique_ptr<RValue> addr_ptr;
+template <typename Word>
+class Mem : public LValue<Word> {
+    std::unique_ptr<RValue<Word>> addr_ptr;
   public:
-    Mem(std::unique_ptr<RValue>&& ptr) : addr_ptr(std::move(ptr)) {}
+    Mem(std::unique_ptr<RValue<Word>>&& ptr) : addr_ptr(std::move(ptr)) {}
     Mem(Mem&& m) = delete;
-    int64_t value(Memory& memory) const noexcept override {
+    Word value(Memory<Word>& memory) const override {
         return memory.get_value(addr_ptr->value(memory));
     }
-    int64_t get_address(Memory& memory) const override {
-        return addr_ptr->value(memory);
+    SourceMode<Word> source_mode() const override {
+        return std::visit([](auto mode) -> SourceMode<Word> { return mode; }, destination_mode());
+    }
+    DestinationMode<Word> destination_mode() const override {
+        auto address_mode = addr_ptr->source_mode();
+        if (auto immediate = std::get_if<ImmediateMode<Word>>(&address_mode))
+            return DirectMode<Word> {immediate->value};
+        if (auto label = std::get_if<LabelMode<Word>>(&address_mode))
+            return LabelledMode<Word> {label->id};
+        return IndirectMode<Word> {addr_ptr.get()};
+    }
+    std::optional<Word> static_value(const Memory<Word>&) const override {
+        return std::nullopt;
+    }
+    void collect_footprint(const Memory<Word>& memory, Footprint<Word>& footprint) const override {
+        addr_ptr->collect_footprint(memory, footprint);
+        auto address = addr_ptr->static_value(memory);
+        if (address && memory.contains(*address))
+            footprint.add_cell(*address);
+        else
+            footprint.make_dynamic();
+    }
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("mem");
+        addr_ptr->hash(hasher);
     }
 };
 
-std::unique_ptr<Mem> mem(std::unique_ptr<RValue> ptr) {
-    return std::make_unique<Mem>(std::move(ptr));
+template <typename Operand>
+std::unique_ptr<Mem<typename Operand::word_type>> mem(std::unique_ptr<Operand> ptr) {
+    return std::make_unique<Mem<typename Operand::word_type>>(std::move(ptr));
 }
 
+template <typename Word>
+class Reg : public LValue<Word> {
+    const size_t index;
+  public:
+    explicit Reg(size_t index) : index(index) {
+        if (index >= REGISTER_COUNT)
+            throw InvalidRegisterException();
+    }
+    Word value(Memory<Word>& memory) const override {
+        return memory.register_at(index);
+    }
+    SourceMode<Word> source_mode() const override {
+        return RegisterMode<Word> {index};
+    }
+    DestinationMode<Word> destination_mode() const override {
+        return RegisterMode<Word> {index};
+    }
+    std::optional<Word> static_value(const Memory<Word>&) const override {
+        return std::nullopt;
+    }
+    void collect_footprint(const Memory<Word>&, Footprint<Word>& footprint) const override {
+        footprint.add_register(index);
+    }
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("reg");
+        hasher.add_word<int64_t>(static_cast<int64_t>(index));
+    }
+};
 
+template <typename Word = int64_t>
+std::unique_ptr<Reg<Word>> reg(size_t index) {
+    return std::make_unique<Reg<Word>>(index);
+}
+
+
+template <typename Word>
 class Instruction {
   public:
-    virtual void pre_evaluate(Memory&) const {}
-    virtual void evaluate(Memory&, Flags&) const = 0;
+    virtual void pre_evaluate(Memory<Word>&) const {}
+    virtual void evaluate(Memory<Word>&, Flags<Word>&) const = 0;
+    virtual void collect_footprint(const Memory<Word>&, Footprint<Word>&) const = 0;
+    virtual void hash(ProgramHasher& hasher) const = 0;
     virtual std::unique_ptr<Instruction> give_ownership() = 0;
     virtual ~Instruction() = default;
 };
 
 
 
-class ArithmeticOperation : public Instruction {
+template <typename Word, typename Operation>
+class ArithmeticOperation : public Instruction<Word> {
   protected:
-    std::unique_ptr<LValue> arg1_ptr;
-    std::unique_ptr<RValue> arg2_ptr;
-    ArithmeticOperation(std::unique_ptr<LValue> lval, std::unique_ptr<RValue> rval)
-        : arg1_ptr(std::move(lval)), arg2_ptr(std::move(rval)) {}
+    std::unique_ptr<LValue<Word>> arg1_ptr;
+    std::unique_ptr<RValue<Word>> arg2_ptr;
+    DestinationMode<Word> arg1_mode;
+    SourceMode<Word> arg2_mode;
+    ArithmeticOperation(std::unique_ptr<LValue<Word>> lval, std::unique_ptr<RValue<Word>> rval)
+        : arg1_ptr(std::move(lval)), arg2_ptr(std::move(rval)),
+          arg1_mode(arg1_ptr->destination_mode()), arg2_mode(arg2_ptr->source_mode()) {}
+    // the modes point into the operands, which stay in place when their owners are moved
     ArithmeticOperation(ArithmeticOperation&& op)
-        : arg1_ptr(std::move(op.arg1_ptr)), arg2_ptr(std::move(op.arg2_ptr)) {}
+        : arg1_ptr(std::move(op.arg1_ptr)), arg2_ptr(std::move(op.arg2_ptr)),
+          arg1_mode(op.arg1_mode), arg2_mode(op.arg2_mode) {}
 
   public:
-    virtual int64_t compute(int64_t, int64_t) const = 0;
-    void evaluate(Memory& memory, Flags& flags) const override {
-        auto result = compute(arg1_ptr->value(memory), arg2_ptr->value(memory));
-        flags.set(result);
-        memory.set_variable(arg1_ptr->get_address(memory), result);
+    Word compute(Word arg1, Word arg2) const {
+        return Operation()(arg1, arg2);
+    }
+    void evaluate(Memory<Word>& memory, Flags<Word>& flags) const override {
+        std::visit(
+            [&](const auto& arg1, const auto& arg2) {
+                Word& target = location(arg1, memory);
+                auto result = compute(target, read(arg2, memory));
+                flags.set(result);
+                target = result;
+            },
+            arg1_mode, arg2_mode);
     }
+    void collect_footprint(const Memory<Word>& memory, Footprint<Word>& footprint) const override {
+        arg1_ptr->collect_footprint(memory, footprint);
+        arg2_ptr->collect_footprint(memory, footprint);
+        footprint.write_flags();
+    }
+
+  protected:
+    void hash_operands(ProgramHasher& hasher) const {
+        arg1_ptr->hash(hasher);
+        arg2_ptr->hash(hasher);
+    }
+
+  public:
     virtual ~ArithmeticOperation() = default;
 };
 
-class add : public ArithmeticOperation {
+template <typename Word = int64_t>
+class add : public ArithmeticOperation<Word, std::plus<Word>> {
   public:
-    add(std::unique_ptr<LValue> lval, std::unique_ptr<RValue> rval)
-        : ArithmeticOperation(std::move(lval), std::move(rval)) {}
+    add(std::unique_ptr<LValue<Word>> lval, std::unique_ptr<RValue<Word>> rval)
+        : ArithmeticOperation<Word, std::plus<Word>>(std::move(lval), std::move(rval)) {}
     // add(add&& a) = default;
-    int64_t compute(int64_t arg1, int64_t arg2) const override {
-        return arg1 + arg2;
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("add");
+        this->hash_operands(hasher);
     }
-    std::unique_ptr<Instruction> give_ownership() override {
+    std::unique_ptr<Instruction<Word>> give_ownership() override {
         return std::make_unique<add>(std::move(*this));
     }
 };
 
-class sub : public ArithmeticOperation {
+template <typename Word = int64_t>
+class sub : public ArithmeticOperation<Word, std::minus<Word>> {
   public:
-    sub(std::unique_ptr<LValue> lval, std::unique_ptr<RValue> rval)
-        : ArithmeticOperation(std::move(lval), std::move(rval)) {}
-    int64_t compute(int64_t arg1, int64_t arg2) const override {
-        return arg1 - arg2;
+    sub(std::unique_ptr<LValue<Word>> lval, std::unique_ptr<RValue<Word>> rval)
+        : ArithmeticOperation<Word, std::minus<Word>>(std::move(lval), std::move(rval)) {}
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("sub");
+        this->hash_operands(hasher);
     }
-    std::unique_ptr<Instruction> give_ownership() override {
+    std::unique_ptr<Instruction<Word>> give_ownership() override {
         return std::make_unique<sub>(std::move(*this));
     }
 };
 
-class inc : public add {
+template <typename Word = int64_t>
+class inc : public add<Word> {
   public:
-    explicit inc(std::unique_ptr<LValue> lval) : add(std::move(lval), num(1)) {}
+    explicit inc(std::unique_ptr<LValue<Word>> lval) : add<Word>(std::move(lval), num<Word>(1)) {}
 };
 
-class dec : public sub {
+template <typename Word = int64_t>
+class dec : public sub<Word> {
   public:
-    explicit dec(std::unique_ptr<LValue> lval) : sub(std::move(lval), num(1)) {}
+    explicit dec(std::unique_ptr<LValue<Word>> lval) : sub<Word>(std::move(lval), num<Word>(1)) {}
 };
 
-class Assignment : public Instruction {
+template <typename Word>
+class Assignment : public Instruction<Word> {
   protected:
-    std::unique_ptr<LValue> arg_ptr;
-    Assignment(std::unique_ptr<LValue> lval) : arg_ptr(std::move(lval)) {}
-    Assignment(Assignment&& a) : arg_ptr(std::move(a.arg_ptr)) {}
+    std::unique_ptr<LValue<Word>> arg_ptr;
+    DestinationMode<Word> arg_mode;
+    Assignment(std::unique_ptr<LValue<Word>> lval)
+        : arg_ptr(std::move(lval)), arg_mode(arg_ptr->destination_mode()) {}
+    Assignment(Assignment&& a) : arg_ptr(std::move(a.arg_ptr)), arg_mode(a.arg_mode) {}
+
+  public:
+    void collect_footprint(const Memory<Word>& memory, Footprint<Word>& footprint) const override {
+        arg_ptr->collect_footprint(memory, footprint);
+    }
 };
 
-class mov : public Assignment {
-    std::unique_ptr<RValue> val_ptr;
+template <typename Word = int64_t>
+class mov : public Assignment<Word> {
+    std::unique_ptr<RValue<Word>> val_ptr;
+    SourceMode<Word> val_mode;
 
   public:
-    mov(std::unique_ptr<LValue> lval, std::unique_ptr<RValue> rval)
-        : Assignment(std::move(lval)), val_ptr(std::move(rval)) {}
-    void evaluate(Memory& memory, Flags& flags) const override {
-        memory.set_variable(arg_ptr->get_address(memory), val_ptr->value(memory));
+    mov(std::unique_ptr<LValue<Word>> lval, std::unique_ptr<RValue<Word>> rval)
+        : Assignment<Word>(std::move(lval)), val_ptr(std::move(rval)),
+          val_mode(val_ptr->source_mode()) {}
+    void evaluate(Memory<Word>& memory, Flags<Word>&) const override {
+        std::visit(
+            [&](const auto& dst, const auto& src) {
+                Word& target = location(dst, memory);
+                target = read(src, memory);
+            },
+            this->arg_mode, val_mode);
+    }
+    void collect_footprint(const Memory<Word>& memory, Footprint<Word>& footprint) const override {
+        Assignment<Word>::collect_footprint(memory, footprint);
+        val_ptr->collect_footprint(memory, footprint);
+    }
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("mov");
+        this->arg_ptr->hash(hasher);
+        val_ptr->hash(hasher);
     }
-    std::unique_ptr<Instruction> give_ownership() override {
+    std::unique_ptr<Instruction<Word>> give_ownership() override {
         return std::make_unique<mov>(std::move(*this));
     }
 };
 
-class one : public Assignment {
+template <typename Word = int64_t>
+class one : public Assignment<Word> {
   public:
-    one(std::unique_ptr<LValue> lval) : Assignment(std::move(lval)) {}
-    void evaluate(Memory& memory, Flags& flags) const override {
-        memory.set_variable(arg_ptr->get_address(memory), 1);
+    one(std::unique_ptr<LValue<Word>> lval) : Assignment<Word>(std::move(lval)) {}
+    void evaluate(Memory<Word>& memory, Flags<Word>& flags) const override {
+        std::visit([&](const auto& dst) { location(dst, memory) = 1; },
+                   this->arg_mode);
     }
-    std::unique_ptr<Instruction> give_ownership() override {
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("one");
+        this->arg_ptr->hash(hasher);
+    }
+    std::unique_ptr<Instruction<Word>> give_ownership() override {
         return std::make_unique<one>(std::move(*this));
     }
 };
 
-class ones : public one {
+template <typename Word = int64_t>
+class ones : public one<Word> {
   public:
-    ones(std::unique_ptr<LValue> lval) : one(std::move(lval)) {}
-    void evaluate(Memory& memory, Flags& flags) const override {
+    ones(std::unique_ptr<LValue<Word>> lval) : one<Word>(std::move(lval)) {}
+    void evaluate(Memory<Word>& memory, Flags<Word>& flags) const override {
         if (flags.is_signed())
-            one::evaluate(memory, flags);
+            one<Word>::evaluate(memory, flags);
+    }
+    void collect_footprint(const Memory<Word>& memory, Footprint<Word>& footprint) const override {
+        one<Word>::collect_footprint(memory, footprint);
+        footprint.read_flags();
+    }
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("ones");
+        this->arg_ptr->hash(hasher);
     }
-    std::unique_ptr<Instruction> give_ownership() override {
+    std::unique_ptr<Instruction<Word>> give_ownership() override {
         return std::make_unique<ones>(std::move(*this));
     }
 };
 
-class onez : public one {
+template <typename Word = int64_t>
+class onez : public one<Word> {
   public:
-    onez(std::unique_ptr<LValue>  lval) : one(std::move(lval)) {}
-    void evaluate(Memory& memory, Flags& flags) const override {
+    onez(std::unique_ptr<LValue<Word>>  lval) : one<Word>(std::move(lval)) {}
+    void evaluate(Memory<Word>& memory, Flags<Word>& flags) const override {
         if (flags.is_zero())
-            one::evaluate(memory, flags);
+            one<Word>::evaluate(memory, flags);
     }
-    std::unique_ptr<Instruction> give_ownership() override {
+    void collect_footprint(const Memory<Word>& memory, Footprint<Word>& footprint) const override {
+        one<Word>::collect_footprint(memory, footprint);
+        footprint.read_flags();
+    }
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("onez");
+        this->arg_ptr->hash(hasher);
+    }
+    std::unique_ptr<Instruction<Word>> give_ownership() override {
         return std::make_unique<onez>(std::move(*this));
     }
 };
 
-class data : public Instruction {
+// Block instructions work on ranges of count consecutive cells. The addresses of the first
+// cells and the count are r-values evaluated once (destination, then source or value, then
+// count), every range is checked once as a whole and the work is done by plain loops over the
+// cells, which the compiler vectorizes. Overlapping ranges behave as if the whole source range
+// was read before the first destination cell is written, like memmove. A range reaching
+// outside the memory throws OutOfBoundsException before any cell is changed.
+template <typename Word>
+class BlockOperation : public Instruction<Word> {
+  protected:
+    std::unique_ptr<RValue<Word>> dst_ptr;
+    std::unique_ptr<RValue<Word>> arg_ptr;
+    std::unique_ptr<RValue<Word>> count_ptr;
+    BlockOperation(std::unique_ptr<RValue<Word>> dst, std::unique_ptr<RValue<Word>> arg,
+                   std::unique_ptr<RValue<Word>> count)
+        : dst_ptr(std::move(dst)), arg_ptr(std::move(arg)), count_ptr(std::move(count)) {}
+    BlockOperation(BlockOperation&& op)
+        : dst_ptr(std::move(op.dst_ptr)), arg_ptr(std::move(op.arg_ptr)),
+          count_ptr(std::move(op.count_ptr)) {}
+
+    void hash_operands(ProgramHasher& hasher) const {
+        dst_ptr->hash(hasher);
+        arg_ptr->hash(hasher);
+        count_ptr->hash(hasher);
+    }
+
+  public:
+    // a whole range per instruction, so dataflow-parallel execution runs them as barriers
+    void collect_footprint(const Memory<Word>&, Footprint<Word>& footprint) const override {
+        footprint.make_dynamic();
+    }
+};
+
+// fill(dst, value, count) - sets count cells starting at address dst to value
+template <typename Word = int64_t>
+class fill : public BlockOperation<Word> {
+  public:
+    fill(std::unique_ptr<RValue<Word>> dst, std::unique_ptr<RValue<Word>> value,
+         std::unique_ptr<RValue<Word>> count)
+        : BlockOperation<Word>(std::move(dst), std::move(value), std::move(count)) {}
+    void evaluate(Memory<Word>& memory, Flags<Word>&) const override {
+        auto dst = this->dst_ptr->value(memory);
+        auto value = this->arg_ptr->value(memory);
+        auto count = this->count_ptr->value(memory);
+        std::fill_n(memory.block(dst, count), static_cast<size_t>(count), value);
+    }
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("fill");
+        this->hash_operands(hasher);
+    }
+    std::unique_ptr<Instruction<Word>> give_ownership() override {
+        return std::make_unique<fill>(std::move(*this));
+    }
+};
+
+// copy(dst, src, count) - copies count cells starting at address src to address dst
+template <typename Word = int64_t>
+class copy : public BlockOperation<Word> {
+  public:
+    copy(std::unique_ptr<RValue<Word>> dst, std::unique_ptr<RValue<Word>> src,
+         std::unique_ptr<RValue<Word>> count)
+        : BlockOperation<Word>(std::move(dst), std::move(src), std::move(count)) {}
+    void evaluate(Memory<Word>& memory, Flags<Word>&) const override {
+        auto dst = this->dst_ptr->value(memory);
+        auto src = this->arg_ptr->value(memory);
+        auto count = this->count_ptr->value(memory);
+        const Word* from = memory.block(src, count);
+        Word* to = memory.block(dst, count);
+        std::memmove(to, from, static_cast<size_t>(count) * sizeof(Word));
+    }
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("copy");
+        this->hash_operands(hasher);
+    }
+    std::unique_ptr<Instruction<Word>> give_ownership() override {
+        return std::make_unique<copy>(std::move(*this));
+    }
+};
+
+// vadd(dst, src, count) - adds every one of count cells starting at address src to the
+// corresponding cell starting at address dst; the flags are set by the last sum, or left
+// unchanged when count is 0
+template <typename Word = int64_t>
+class vadd : public BlockOperation<Word> {
+  public:
+    vadd(std::unique_ptr<RValue<Word>> dst, std::unique_ptr<RValue<Word>> src,
+         std::unique_ptr<RValue<Word>> count)
+        : BlockOperation<Word>(std::move(dst), std::move(src), std::move(count)) {}
+    void evaluate(Memory<Word>& memory, Flags<Word>& flags) const override {
+        auto dst = this->dst_ptr->value(memory);
+        auto src = this->arg_ptr->value(memory);
+        auto count = this->count_ptr->value(memory);
+        const Word* from = memory.block(src, count);
+        Word* to = memory.block(dst, count);
+        if (count == 0)
+            return;
+        auto n = static_cast<size_t>(count);
+        // when the destination starts inside the source, going backwards reads every source
+        // cell before it is overwritten
+        if (to > from && to < from + n) {
+            for (size_t i = n; i-- > 0;)
+                to[i] += from[i];
+        }
+        else {
+            for (size_t i = 0; i < n; i++)
+                to[i] += from[i];
+        }
+        flags.set(to[n - 1]);
+    }
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("vadd");
+        this->hash_operands(hasher);
+    }
+    std::unique_ptr<Instruction<Word>> give_ownership() override {
+        return std::make_unique<vadd>(std::move(*this));
+    }
+};
+
+template <typename Word = int64_t>
+class data : public Instruction<Word> {
   private:
     std::string id;
-    std::unique_ptr<RValue> rval_ptr;
+    std::unique_ptr<RValue<Word>> rval_ptr;
 
   public:
-    data(const char* text, std::unique_ptr<RValue> rval)
+    data(const char* text, std::unique_ptr<RValue<Word>> rval)
         : id(convert_to_string(text)), rval_ptr(std::move(rval)) {}
-    void pre_evaluate(Memory& memory) const override {
+    void pre_evaluate(Memory<Word>& memory) const override {
         memory.declare_variable(id, rval_ptr->value(memory));
     }
-    void evaluate(Memory& memory, Flags& flags) const override {}
-    std::unique_ptr<Instruction> give_ownership() override {
+    void evaluate(Memory<Word>& memory, Flags<Word>& flags) const override {}
+    void collect_footprint(const Memory<Word>&, Footprint<Word>&) const override {}
+    void hash(ProgramHasher& hasher) const override {
+        hasher.add_text("data");
+        hasher.add_text(id);
+        rval_ptr->hash(hasher);
+    }
+    std::unique_ptr<Instruction<Word>> give_ownership() override {
         return std::make_unique<data>(std::move(*this));
     }
 };
 
+// The word type of an instruction is taken from its operands, so that add(mem(num(0)), num(1))
+// still spells a 64-bit instruction and add(mem(num<int32_t>(0)), num<int32_t>(1)) a 32-bit one.
+template <typename Dst, typename Src>
+add(std::unique_ptr<Dst>, std::unique_ptr<Src>) -> add<typename Dst::word_type>;
+template <typename Dst, typename Src>
+sub(std::unique_ptr<Dst>, std::unique_ptr<Src>) -> sub<typename Dst::word_type>;
+template <typename Dst>
+inc(std::unique_ptr<Dst>) -> inc<typename Dst::word_type>;
+template <typename Dst>
+dec(std::unique_ptr<Dst>) -> dec<typename Dst::word_type>;
+template <typename Dst, typename Src>
+mov(std::unique_ptr<Dst>, std::unique_ptr<Src>) -> mov<typename Dst::word_type>;
+template <typename Dst>
+one(std::unique_ptr<Dst>) -> one<typename Dst::word_type>;
+template <typename Dst>
+ones(std::unique_ptr<Dst>) -> ones<typename Dst::word_type>;
+template <typename Dst>
+onez(std::unique_ptr<Dst>) -> onez<typename Dst::word_type>;
+template <typename Src>
+data(const char*, std::unique_ptr<Src>) -> data<typename Src::word_type>;
+template <typename Dst, typename Value, typename Count>
+fill(std::unique_ptr<Dst>, std::unique_ptr<Value>, std::unique_ptr<Count>)
+    -> fill<typename Dst::word_type>;
+template <typename Dst, typename Src, typename Count>
+copy(std::unique_ptr<Dst>, std::unique_ptr<Src>, std::unique_ptr<Count>)
+    -> copy<typename Dst::word_type>;
+template <typename Dst, typename Src, typename Count>
+vadd(std::unique_ptr<Dst>, std::unique_ptr<Src>, std::unique_ptr<Count>)
+    -> vadd<typename Dst::word_type>;
+
+template <typename Word>
 class InstructionPtr {
-    std::shared_ptr<Instruction> ptr; // unique_ptr causes problems with std::initializer_list
+    std::shared_ptr<const Instruction<Word>> ptr; // unique_ptr causes problems with std::initializer_list
   public:
-    InstructionPtr(Instruction&& instr) : ptr(instr.give_ownership()) {}
-    const Instruction& get() {
+    InstructionPtr(Instruction<Word>&& instr) : ptr(instr.give_ownership()) {}
+    const Instruction<Word>& get() const {
         return *ptr;
     }
 };
 
-class program {
+// Position of a single run in a program. Programs are immutable once built, so any number of
+// cursors, also in different threads, may walk the same program at once.
+template <typename Word>
+class ProgramCursor {
   private:
-    std::vector<InstructionPtr> instructions;
+    const std::vector<InstructionPtr<Word>>& instructions;
     size_t index_of_next = 0;
 
   public:
-    program(std::vector<InstructionPtr>&& vec) : instructions(std::move(vec)) {}
-    const Instruction& get_next_instruction() {
+    explicit ProgramCursor(const std::vector<InstructionPtr<Word>>& instructions)
+        : instructions(instructions) {}
+    const Instruction<Word>& get_next_instruction() {
         if (!has_next_instruction())
             throw EndOfProgramException();
         return instructions[index_of_next++].get();
@@ -344,8 +1066,31 @@ class program {
     bool has_next_instruction() const {
         return index_of_next < instructions.size();
     }
-    void go_to_start() {
-        index_of_next = 0;
+};
+
+template <typename Word = int64_t>
+class program {
+  private:
+    std::vector<InstructionPtr<Word>> instructions;
+    ProgramHash hash;
+
+    ProgramHash compute_hash() const {
+        ProgramHasher hasher;
+        hasher.add_word<int64_t>(sizeof(Word));
+        for (const auto& instruction : instructions)
+            instruction.get().hash(hasher);
+        return hasher.digest();
+    }
+
+  public:
+    program(std::vector<InstructionPtr<Word>>&& vec)
+        : instructions(std::move(vec)), hash(compute_hash()) {}
+    ProgramCursor<Word> start() const {
+        return ProgramCursor<Word>(instructions);
+    }
+    // the same for programs made of the same instructions, also in other processes
+    const ProgramHash& content_hash() const noexcept {
+        return hash;
     }
 };
 
@@ -0,0 +1,232 @@
+#ifndef JNP_6_PERF_COUNTERS_H
+#define JNP_6_PERF_COUNTERS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware events counted around the phases of Computer::boot.
+enum class HardwareEvent { CYCLES, INSTRUCTIONS, BRANCH_MISSES, CACHE_MISSES, DTLB_MISSES };
+
+enum class BootPhase { RESET, DECLARATION, EXECUTION, DUMP };
+
+// Linux hardware performance counters of the calling thread, opened with perf_event_open.
+// Every event is opened separately, so that the ones the CPU, the kernel or a virtual machine
+// does not provide (or perf_event_paranoid forbids) are simply reported as unavailable.
+// Threads started by the measured code are not counted.
+class HardwareCounters {
+  public:
+    const static size_t EVENT_COUNT = 5;
+    using Reading = std::array<std::optional<uint64_t>, EVENT_COUNT>;
+
+    HardwareCounters() {
+        for (size_t i = 0; i < EVENT_COUNT; i++)
+            descriptors[i] = open_event(static_cast<HardwareEvent>(i));
+    }
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+    ~HardwareCounters() {
+#ifdef __linux__
+        for (auto fd : descriptors)
+            if (fd >= 0)
+                close(fd);
+#endif
+    }
+
+    static const char* event_name(HardwareEvent event) noexcept {
+        static const char* const names[EVENT_COUNT] = {"cycles", "instructions", "branch-misses",
+                                                        "cache-misses", "dTLB-misses"};
+        return names[static_cast<size_t>(event)];
+    }
+    bool is_available(HardwareEvent event) const noexcept {
+        return descriptors[static_cast<size_t>(event)] >= 0;
+    }
+
+    void start() noexcept {
+#ifdef __linux__
+        for (auto fd : descriptors) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+    Reading stop() noexcept {
+        Reading reading;
+#ifdef __linux__
+        for (auto fd : descriptors)
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        for (size_t i = 0; i < EVENT_COUNT; i++)
+            reading[i] = read_event(descriptors[i]);
+#endif
+        return reading;
+    }
+
+  private:
+#ifdef __linux__
+    static int open_event(HardwareEvent event) noexcept {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        switch (event) {
+        case HardwareEvent::CYCLES:
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case HardwareEvent::INSTRUCTIONS:
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case HardwareEvent::BRANCH_MISSES:
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case HardwareEvent::CACHE_MISSES:
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case HardwareEvent::DTLB_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        }
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    // Counts are scaled up when the kernel had to multiplex the counter with other events.
+    static std::optional<uint64_t> read_event(int fd) noexcept {
+        uint64_t values[3]; // value, time enabled, time running
+        if (fd < 0 || read(fd, values, sizeof(values)) != sizeof(values) || values[2] == 0)
+            return std::nullopt;
+        if (values[2] < values[1])
+            return static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+        return values[0];
+    }
+#else
+    static int open_event(HardwareEvent) noexcept {
+        return -1;
+    }
+#endif
+
+    std::array<int, EVENT_COUNT> descriptors;
+};
+
+// Hardware counters and wall time accumulated per boot phase over any number of boots,
+// together with the number of OOAsm instructions executed, used to normalize the counts.
+class BootProfile {
+  public:
+    const static size_t PHASE_COUNT = 4;
+
+    template <typename Action>
+    void measure(BootPhase phase, Action&& action) {
+        Measurement measurement(*this, phase);
+        action();
+    }
+    void count_instructions(uint64_t executed) noexcept {
+        instructions_executed += executed;
+    }
+
+    std::optional<uint64_t> get(BootPhase phase, HardwareEvent event) const noexcept {
+        return totals[static_cast<size_t>(phase)][static_cast<size_t>(event)];
+    }
+    std::chrono::nanoseconds get_time(BootPhase phase) const noexcept {
+        return times[static_cast<size_t>(phase)];
+    }
+    uint64_t get_instructions_executed() const noexcept {
+        return instructions_executed;
+    }
+
+    void report(std::ostream& stream) const {
+        static const char* const phase_names[PHASE_COUNT] = {"reset", "declaration", "execution",
+                                                             "dump"};
+        stream << std::left << std::setw(12) << "phase" << std::right << std::setw(14)
+               << "time[ns]";
+        for (size_t event = 0; event < HardwareCounters::EVENT_COUNT; event++)
+            stream << std::setw(15)
+                   << HardwareCounters::event_name(static_cast<HardwareEvent>(event));
+        stream << "\n";
+        for (size_t phase = 0; phase < PHASE_COUNT; phase++) {
+            stream << std::left << std::setw(12) << phase_names[phase] << std::right
+                   << std::setw(14) << times[phase].count();
+            for (const auto& total : totals[phase]) {
+                if (total)
+                    stream << std::setw(15) << *total;
+                else
+                    stream << std::setw(15) << "n/a";
+            }
+            stream << "\n";
+        }
+
+        stream << "per executed instruction (" << instructions_executed << "):";
+        if (instructions_executed == 0) {
+            stream << " -\n";
+            return;
+        }
+        const auto& execution = totals[static_cast<size_t>(BootPhase::EXECUTION)];
+        for (size_t event = 0; event < HardwareCounters::EVENT_COUNT; event++) {
+            stream << " " << HardwareCounters::event_name(static_cast<HardwareEvent>(event))
+                   << "=";
+            if (execution[event])
+                stream << static_cast<double>(*execution[event]) / instructions_executed;
+            else
+                stream << "n/a";
+        }
+        stream << "\n";
+    }
+
+  private:
+    // counts the enclosing scope, also when it is left by an exception
+    class Measurement {
+      public:
+        Measurement(BootProfile& profile, BootPhase phase)
+            : profile(profile), phase(static_cast<size_t>(phase)),
+              start(std::chrono::steady_clock::now()) {
+            profile.counters.start();
+        }
+        ~Measurement() {
+            auto reading = profile.counters.stop();
+            profile.times[phase] += std::chrono::steady_clock::now() - start;
+            for (size_t event = 0; event < HardwareCounters::EVENT_COUNT; event++)
+                if (reading[event])
+                    profile.totals[phase][event] =
+                        profile.totals[phase][event].value_or(0) + *reading[event];
+        }
+
+      private:
+        BootProfile& profile;
+        size_t phase;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    HardwareCounters counters;
+    std::array<HardwareCounters::Reading, PHASE_COUNT> totals {};
+    std::array<std::chrono::nanoseconds, PHASE_COUNT> times {};
+    uint64_t instructions_executed = 0;
+};
+
+// Stand-in for BootProfile when boot is not instrumented; compiles down to the bare phases.
+class NoProfile {
+  public:
+    template <typename Action>
+    void measure(BootPhase, Action&& action) {
+        action();
+    }
+    void count_instructions(uint64_t) noexcept {}
+};
+
+#endif // JNP_6_PERF_COUNTERS_H
@@ -0,0 +1,156 @@
+#ifndef JNP_6_PLACED_STORAGE_H
+#define JNP_6_PLACED_STORAGE_H
+
+#include "ooasm.h"
+#include <cerrno>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Pages backing the memory cells. TRANSPARENT asks the kernel to back the cells with huge
+// pages when it can (madvise); HUGE_2MB and HUGE_1GB take them from the reserved hugetlb pool
+// and fail when it is too small.
+enum class PageSize { DEFAULT, TRANSPARENT, HUGE_2MB, HUGE_1GB };
+
+// NUMA nodes the pages of the cells come from: the node of the thread touching them first
+// (DEFAULT), only the given nodes (BIND) or the given nodes in turn, page by page (INTERLEAVE).
+enum class NumaPolicy { DEFAULT, BIND, INTERLEAVE };
+
+struct MemoryPlacement {
+    PageSize pages = PageSize::DEFAULT;
+    NumaPolicy policy = NumaPolicy::DEFAULT;
+    std::vector<unsigned> nodes;
+};
+
+class InvalidNumaNodeException : public std::exception {
+  public:
+    const char* what() const noexcept override {
+        return "NUMA node with given number does not exist!";
+    }
+};
+
+// Memory cells in anonymous pages of the given size, placed on NUMA nodes with mbind before
+// they are touched. Random accesses over large memories (e.g. mem(mem(...))) then miss the TLB
+// less often and stay on the node of the threads running the computer (see
+// pin_thread_to_numa_node). The cells start zeroed.
+template <typename Word>
+class PlacedStorage : public Storage<Word> {
+  public:
+    PlacedStorage(size_t mem_size, const MemoryPlacement& placement) : memory_size(mem_size) {
+        if (mem_size == 0) // mmap of zero bytes is not allowed
+            return;
+        size_t page = page_bytes(placement.pages);
+        mapped_bytes = (mem_size * sizeof(Word) + page - 1) / page * page;
+        void* address = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | mmap_flags(placement.pages), -1, 0);
+        if (address == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        memory_array = static_cast<Word*>(address);
+        try {
+            if (placement.pages == PageSize::TRANSPARENT &&
+                madvise(address, mapped_bytes, MADV_HUGEPAGE) != 0)
+                throw std::system_error(errno, std::generic_category(), "madvise");
+            bind(placement);
+        }
+        catch (...) {
+            munmap(memory_array, mapped_bytes);
+            throw;
+        }
+    }
+    PlacedStorage(const PlacedStorage&) = delete;
+    PlacedStorage& operator=(const PlacedStorage&) = delete;
+    ~PlacedStorage() override {
+        if (memory_array != nullptr)
+            munmap(memory_array, mapped_bytes);
+    }
+
+    Word* cells() noexcept override {
+        return memory_array;
+    }
+    size_t size() const noexcept override {
+        return memory_size;
+    }
+
+  private:
+    const static size_t MAX_NODES = 1024;
+    const static size_t NODE_MASK_BITS = 8 * sizeof(unsigned long);
+
+    static size_t page_bytes(PageSize pages) noexcept {
+        switch (pages) {
+        case PageSize::HUGE_2MB:
+            return size_t(1) << 21;
+        case PageSize::HUGE_1GB:
+            return size_t(1) << 30;
+        default:
+            return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        }
+    }
+
+    static int mmap_flags(PageSize pages) noexcept {
+        switch (pages) {
+        case PageSize::HUGE_2MB:
+            return MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+        case PageSize::HUGE_1GB:
+            return MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+        default:
+            return 0;
+        }
+    }
+
+    // with the raw system call, so that libnuma is not needed; the kernel reads maxnode - 1 bits
+    void bind(const MemoryPlacement& placement) {
+        if (placement.policy == NumaPolicy::DEFAULT)
+            return;
+        std::vector<unsigned long> mask(MAX_NODES / NODE_MASK_BITS, 0);
+        for (auto node : placement.nodes) {
+            if (node >= MAX_NODES)
+                throw InvalidNumaNodeException();
+            mask[node / NODE_MASK_BITS] |= 1UL << (node % NODE_MASK_BITS);
+        }
+        int mode = placement.policy == NumaPolicy::BIND ? MPOL_BIND : MPOL_INTERLEAVE;
+        if (syscall(SYS_mbind, memory_array, mapped_bytes, mode, mask.data(), MAX_NODES + 1,
+                    MPOL_MF_STRICT) != 0) {
+            if (errno == EINVAL)
+                throw InvalidNumaNodeException();
+            throw std::system_error(errno, std::generic_category(), "mbind");
+        }
+    }
+
+    size_t memory_size;
+    size_t mapped_bytes = 0;
+    Word* memory_array = nullptr;
+};
+
+// Restricts the calling thread to the CPUs of the given NUMA node, so that a computer booted
+// on it accesses memory bound to that node locally.
+inline void pin_thread_to_numa_node(unsigned node) {
+    std::ifstream cpu_list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!cpu_list)
+        throw InvalidNumaNodeException();
+    // ranges separated by commas, e.g. "0-7,16-23"
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    unsigned first, last;
+    while (cpu_list >> first) {
+        last = first;
+        if (cpu_list.peek() == '-')
+            cpu_list.ignore() >> last;
+        for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, &cpus);
+        if (cpu_list.peek() == ',')
+            cpu_list.ignore();
+    }
+    if (CPU_COUNT(&cpus) == 0)
+        throw InvalidNumaNodeException();
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+        throw std::system_error(errno, std::generic_category(), "sched_setaffinity");
+}
+
+#endif // JNP_6_PLACED_STORAGE_H
@@ -0,0 +1,229 @@
+#ifndef JNP_6_PROGRAM_STREAM_H
+#define JNP_6_PROGRAM_STREAM_H
+
+#include "ooasm.h"
+#include <fstream>
+#include <future>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+class ProgramSyntaxException : public std::exception {
+  public:
+    const char* what() const noexcept override {
+        return "Invalid instruction in program file!";
+    }
+};
+
+// Decoder of the text form of programs: one instruction per line, written with the names of
+// the instructions and operands of the DSL in prefix order, without parentheses and commas,
+// e.g. `data x num 5`, `add mem lea x mem num 0`, `fill num 0 num 3 num 100`. Empty lines and
+// lines starting with '#' are skipped. Numbers are decimal and have to fit in a Word.
+template <typename Word>
+class ProgramDecoder {
+  public:
+    using InstructionList = std::vector<std::unique_ptr<Instruction<Word>>>;
+
+    explicit ProgramDecoder(std::istream& input) : input(input) {}
+
+    // up to max_instructions next instructions, fewer only at the end of the input
+    InstructionList decode_window(size_t max_instructions) {
+        InstructionList window;
+        window.reserve(max_instructions);
+        std::string line;
+        while (window.size() < max_instructions && std::getline(input, line)) {
+            Tokens tokens {line};
+            if (tokens.at_end() || line[tokens.position] == '#')
+                continue;
+            window.push_back(decode_instruction(tokens.next(), tokens));
+            if (!tokens.at_end())
+                throw ProgramSyntaxException();
+        }
+        if (input.bad())
+            throw std::system_error(errno, std::generic_category(), "read program");
+        return window;
+    }
+
+  private:
+    // words of a line, split by hand since istringstream dominates the decoding time
+    struct Tokens {
+        std::string_view line;
+        size_t position = 0;
+
+        bool at_end() {
+            skip_spaces();
+            return position == line.size();
+        }
+        std::string_view next() {
+            if (at_end())
+                throw ProgramSyntaxException();
+            size_t begin = position;
+            while (position < line.size() && !is_space(line[position]))
+                position++;
+            return line.substr(begin, position - begin);
+        }
+
+      private:
+        static bool is_space(char c) noexcept {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+        void skip_spaces() noexcept {
+            while (position < line.size() && is_space(line[position]))
+                position++;
+        }
+    };
+
+    static std::unique_ptr<Instruction<Word>> decode_instruction(std::string_view name,
+                                                                 Tokens& tokens) {
+        if (name == "data") {
+            std::string id(tokens.next());
+            return std::make_unique<data<Word>>(id.c_str(), decode_rvalue(tokens));
+        }
+        if (name == "add" || name == "sub" || name == "mov") {
+            auto arg1 = decode_lvalue(tokens);
+            auto arg2 = decode_rvalue(tokens);
+            if (name == "add")
+                return std::make_unique<add<Word>>(std::move(arg1), std::move(arg2));
+            if (name == "sub")
+                return std::make_unique<sub<Word>>(std::move(arg1), std::move(arg2));
+            return std::make_unique<mov<Word>>(std::move(arg1), std::move(arg2));
+        }
+        if (name == "inc")
+            return std::make_unique<inc<Word>>(decode_lvalue(tokens));
+        if (name == "dec")
+            return std::make_unique<dec<Word>>(decode_lvalue(tokens));
+        if (name == "one")
+            return std::make_unique<one<Word>>(decode_lvalue(tokens));
+        if (name == "ones")
+            return std::make_unique<ones<Word>>(decode_lvalue(tokens));
+        if (name == "onez")
+            return std::make_unique<onez<Word>>(decode_lvalue(tokens));
+        if (name == "fill" || name == "copy" || name == "vadd") {
+            auto dst = decode_rvalue(tokens);
+            auto arg = decode_rvalue(tokens);
+            auto count = decode_rvalue(tokens);
+            if (name == "fill")
+                return std::make_unique<fill<Word>>(std::move(dst), std::move(arg),
+                                                    std::move(count));
+            if (name == "copy")
+                return std::make_unique<copy<Word>>(std::move(dst), std::move(arg),
+                                                    std::move(count));
+            return std::make_unique<vadd<Word>>(std::move(dst), std::move(arg), std::move(count));
+        }
+        throw ProgramSyntaxException();
+    }
+
+    static std::unique_ptr<LValue<Word>> decode_lvalue(Tokens& tokens) {
+        auto name = tokens.next();
+        if (name == "mem")
+            return mem(decode_rvalue(tokens));
+        if (name == "reg")
+            return reg<Word>(decode_register(tokens));
+        throw ProgramSyntaxException();
+    }
+
+    static std::unique_ptr<RValue<Word>> decode_rvalue(Tokens& tokens) {
+        auto name = tokens.next();
+        if (name == "num")
+            return num<Word>(decode_number(tokens));
+        if (name == "lea")
+            return lea<Word>(std::string(tokens.next()).c_str());
+        if (name == "mem")
+            return mem(decode_rvalue(tokens));
+        if (name == "reg")
+            return reg<Word>(decode_register(tokens));
+        throw ProgramSyntaxException();
+    }
+
+    static Word decode_number(Tokens& tokens) {
+        auto number = parse_word<Word>(tokens.next());
+        if (!number)
+            throw ProgramSyntaxException();
+        return *number;
+    }
+
+    // checked before the cast, so that e.g. a 128-bit number cannot wrap to a valid register
+    static size_t decode_register(Tokens& tokens) {
+        Word index = decode_number(tokens);
+        if (index < 0 || index >= static_cast<Word>(REGISTER_COUNT))
+            throw ProgramSyntaxException();
+        return static_cast<size_t>(index);
+    }
+
+    std::istream& input;
+};
+
+// Position of a single pass over a program file. Instructions are decoded in windows of a
+// fixed number of instructions, and the next window is decoded on another thread while the
+// current one is executed, so at most two windows are held at a time. An instruction returned
+// by get_next_instruction stays valid until the next call.
+template <typename Word>
+class ProgramStreamCursor {
+  public:
+    using InstructionList = typename ProgramDecoder<Word>::InstructionList;
+
+    ProgramStreamCursor(const std::string& path, size_t window_size)
+        : file(std::make_unique<std::ifstream>(path)), decoder(*file), window_size(window_size) {
+        if (!*file)
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        window = decoder.decode_window(window_size);
+        read_ahead();
+    }
+    ProgramStreamCursor(const ProgramStreamCursor&) = delete;
+    ProgramStreamCursor& operator=(const ProgramStreamCursor&) = delete;
+    ~ProgramStreamCursor() {
+        if (next_window.valid())
+            next_window.wait();
+    }
+
+    const Instruction<Word>& get_next_instruction() {
+        if (!has_next_instruction())
+            throw EndOfProgramException();
+        return *window[index_of_next++];
+    }
+    bool has_next_instruction() {
+        if (index_of_next == window.size() && window.size() == window_size) {
+            window = next_window.get();
+            index_of_next = 0;
+            read_ahead();
+        }
+        return index_of_next < window.size();
+    }
+
+  private:
+    void read_ahead() {
+        // a shorter window means the whole file has been decoded
+        if (window.size() == window_size)
+            next_window = std::async(std::launch::async,
+                                     [this] { return decoder.decode_window(window_size); });
+    }
+
+    std::unique_ptr<std::ifstream> file;
+    ProgramDecoder<Word> decoder;
+    size_t window_size;
+    InstructionList window;
+    size_t index_of_next = 0;
+    std::future<InstructionList> next_window;
+};
+
+// Program kept in a file in the text form read by ProgramDecoder, for programs too large to be
+// held in memory as a program. Every pass of boot reads the file again through its own cursor,
+// so the memory used does not depend on the length of the program, only on window_size.
+template <typename Word = int64_t>
+class ProgramStream {
+  public:
+    const static size_t DEFAULT_WINDOW_SIZE = 1 << 14;
+
+    explicit ProgramStream(std::string path, size_t window_size = DEFAULT_WINDOW_SIZE)
+        : path(std::move(path)), window_size(std::max<size_t>(window_size, 1)) {}
+    ProgramStreamCursor<Word> start() const {
+        return ProgramStreamCursor<Word>(path, window_size);
+    }
+
+  private:
+    std::string path;
+    size_t window_size;
+};
+
+#endif // JNP_6_PROGRAM_STREAM_H
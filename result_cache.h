@@ -0,0 +1,267 @@
+#ifndef JNP_6_RESULT_CACHE_H
+#define JNP_6_RESULT_CACHE_H
+
+#include "ooasm.h"
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <mutex>
+#include <random>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Exceptions of the OOAsm machine a run may end with, in a form that can be stored.
+enum class BootError : uint8_t {
+    NONE,
+    END_OF_PROGRAM,
+    OUT_OF_BOUNDS,
+    MEMORY_OVERFLOW,
+    WRONG_VAR_NAME,
+    INVALID_IDENTIFIER
+};
+
+// BootError of the given exception, or nothing for exceptions not coming from the machine
+// (e.g. std::bad_alloc), whose outcome must not be remembered.
+inline std::optional<BootError> classify_boot_error(std::exception_ptr error) {
+    try {
+        std::rethrow_exception(error);
+    }
+    catch (const EndOfProgramException&) {
+        return BootError::END_OF_PROGRAM;
+    }
+    catch (const OutOfBoundsException&) {
+        return BootError::OUT_OF_BOUNDS;
+    }
+    catch (const MemoryOverflowException&) {
+        return BootError::MEMORY_OVERFLOW;
+    }
+    catch (const WrongVarNameException&) {
+        return BootError::WRONG_VAR_NAME;
+    }
+    catch (const InvalidIdentifierException&) {
+        return BootError::INVALID_IDENTIFIER;
+    }
+    catch (...) {
+        return std::nullopt;
+    }
+}
+
+[[noreturn]] inline void throw_boot_error(BootError error) {
+    switch (error) {
+    case BootError::END_OF_PROGRAM:
+        throw EndOfProgramException();
+    case BootError::OUT_OF_BOUNDS:
+        throw OutOfBoundsException();
+    case BootError::MEMORY_OVERFLOW:
+        throw MemoryOverflowException();
+    case BootError::WRONG_VAR_NAME:
+        throw WrongVarNameException();
+    case BootError::INVALID_IDENTIFIER:
+        throw InvalidIdentifierException();
+    case BootError::NONE:
+        break;
+    }
+    std::terminate();
+}
+
+// Everything a boot depends on. Flags are part of it, because they survive between boots and
+// ones/onez may read them before any arithmetic instruction sets them.
+struct BootKey {
+    ProgramHash program;
+    uint64_t mem_size = 0;
+    bool zero = false, sign = false;
+
+    bool operator==(const BootKey& other) const noexcept {
+        return program == other.program && mem_size == other.mem_size && zero == other.zero &&
+               sign == other.sign;
+    }
+};
+
+struct BootKeyHash {
+    size_t operator()(const BootKey& key) const noexcept {
+        return static_cast<size_t>(key.program.low ^ (key.mem_size * 0x9e3779b97f4a7c15ULL) ^
+                                   (key.zero ? 1 : 0) ^ (key.sign ? 2 : 0));
+    }
+};
+
+// Final state of a run: memory image, flags and the exception it ended with, if any.
+template <typename Word>
+struct BootOutcome {
+    std::vector<Word> memory_image;
+    bool zero = false, sign = false;
+    BootError error = BootError::NONE;
+};
+
+struct ResultCacheStatistics {
+    uint64_t hits = 0;      // served from memory
+    uint64_t disk_hits = 0; // served from the on-disk store
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t bytes = 0; // size of the entries held in memory, see ResultCache::entry_bytes
+};
+
+// Memoization of boot outcomes. A straight-line program booted with the same memory size and
+// flags always ends in the same state, so outcomes are kept in a LRU bounded by the total size
+// of their memory images plus a fixed cost per entry and, optionally, in a directory with one
+// file per outcome, which is never evicted. Safe to share between computers running in
+// different threads.
+template <typename Word>
+class ResultCache {
+  public:
+    using Outcome = std::shared_ptr<const BootOutcome<Word>>;
+
+    // cost of an entry on top of its memory image, so that outcomes of empty memories are
+    // bounded by the capacity as well
+    const static size_t ENTRY_OVERHEAD_BYTES = 128;
+
+    explicit ResultCache(size_t capacity_bytes, std::optional<std::string> directory = std::nullopt)
+        : capacity_bytes(capacity_bytes), directory(std::move(directory)) {}
+
+    Outcome find(const BootKey& key) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            if (it != entries.end()) {
+                recently_used.splice(recently_used.begin(), recently_used, it->second.position);
+                statistics.hits++;
+                return it->second.outcome;
+            }
+        }
+        if (auto outcome = load(key)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            statistics.disk_hits++;
+            remember(key, outcome);
+            return outcome;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        statistics.misses++;
+        return nullptr;
+    }
+
+    void insert(const BootKey& key, BootOutcome<Word>&& result) {
+        auto outcome = std::make_shared<const BootOutcome<Word>>(std::move(result));
+        store(key, *outcome);
+        std::lock_guard<std::mutex> lock(mutex);
+        remember(key, outcome);
+    }
+
+    ResultCacheStatistics get_statistics() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return statistics;
+    }
+
+  private:
+    struct Entry {
+        Outcome outcome;
+        typename std::list<BootKey>::iterator position;
+    };
+
+    static size_t image_bytes(const BootOutcome<Word>& outcome) noexcept {
+        return outcome.memory_image.size() * sizeof(Word);
+    }
+    static size_t entry_bytes(const BootOutcome<Word>& outcome) noexcept {
+        return image_bytes(outcome) + ENTRY_OVERHEAD_BYTES;
+    }
+
+    // requires the lock
+    void remember(const BootKey& key, const Outcome& outcome) {
+        if (entry_bytes(*outcome) > capacity_bytes || entries.count(key) != 0)
+            return;
+        while (statistics.bytes + entry_bytes(*outcome) > capacity_bytes) {
+            auto victim = entries.find(recently_used.back());
+            statistics.bytes -= entry_bytes(*victim->second.outcome);
+            entries.erase(victim);
+            recently_used.pop_back();
+            statistics.evictions++;
+        }
+        recently_used.push_front(key);
+        entries.emplace(key, Entry {outcome, recently_used.begin()});
+        statistics.bytes += entry_bytes(*outcome);
+    }
+
+    // On-disk format: magic, word size, number of cells, flags, error, cells in host byte order.
+    const static uint64_t FILE_MAGIC = 0x3143525f4d534f4fULL; // "OOSM_RC1"
+
+    std::string path_of(const BootKey& key) const {
+        std::ostringstream name;
+        name << *directory << "/" << std::hex << std::setfill('0') << std::setw(16)
+             << key.program.high << std::setw(16) << key.program.low << std::dec << "-"
+             << key.mem_size << "-" << key.zero << key.sign << ".ooasm";
+        return name.str();
+    }
+
+    // unique among the processes and threads sharing the directory, without POSIX getpid
+    static std::string temporary_suffix() {
+        static const uint64_t process_tag = std::random_device()() ^
+                                            uint64_t(std::random_device()()) << 32;
+        static std::atomic<uint64_t> counter {0};
+        std::ostringstream suffix;
+        suffix << std::hex << process_tag << "-"
+               << std::hash<std::thread::id>()(std::this_thread::get_id()) << "-" << counter++;
+        return suffix.str();
+    }
+
+    void store(const BootKey& key, const BootOutcome<Word>& outcome) const {
+        if (!directory)
+            return;
+        // written aside and renamed, so that readers never see a partial file
+        auto path = path_of(key);
+        auto temporary = path + ".tmp" + temporary_suffix();
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            uint64_t header[4] = {FILE_MAGIC, sizeof(Word), outcome.memory_image.size(),
+                                  static_cast<uint64_t>(outcome.zero) |
+                                      static_cast<uint64_t>(outcome.sign) << 1 |
+                                      static_cast<uint64_t>(outcome.error) << 8};
+            file.write(reinterpret_cast<const char*>(header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(outcome.memory_image.data()),
+                       image_bytes(outcome));
+            if (!file) {
+                file.close();
+                std::remove(temporary.c_str());
+                return;
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+            std::remove(temporary.c_str());
+    }
+
+    Outcome load(const BootKey& key) const {
+        if (!directory)
+            return nullptr;
+        std::ifstream file(path_of(key), std::ios::binary);
+        uint64_t header[4];
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+            header[0] != FILE_MAGIC || header[1] != sizeof(Word) || header[2] != key.mem_size)
+            return nullptr;
+        // a damaged or foreign file is a miss, not an error to rethrow
+        if ((header[3] & ~uint64_t(0xff03)) != 0 ||
+            (header[3] >> 8) > static_cast<uint64_t>(BootError::INVALID_IDENTIFIER))
+            return nullptr;
+        BootOutcome<Word> outcome;
+        outcome.memory_image.resize(header[2]);
+        outcome.zero = header[3] & 1;
+        outcome.sign = header[3] & 2;
+        outcome.error = static_cast<BootError>(header[3] >> 8);
+        if (!file.read(reinterpret_cast<char*>(outcome.memory_image.data()), image_bytes(outcome)))
+            return nullptr;
+        return std::make_shared<const BootOutcome<Word>>(std::move(outcome));
+    }
+
+    size_t capacity_bytes;
+    std::optional<std::string> directory;
+
+    mutable std::mutex mutex;
+    std::list<BootKey> recently_used;
+    std::unordered_map<BootKey, Entry, BootKeyHash> entries;
+    ResultCacheStatistics statistics;
+};
+
+#endif // JNP_6_RESULT_CACHE_H
@@ -0,0 +1,68 @@
+#include "ooasm.h"
+#include "computer.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+
+namespace {
+std::string memory_dump(Computer const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+}
+
+int main() {
+    auto ooasm_fill = program({
+                                  data("buf", num(9)),
+                                  fill(lea("buf"), num(7), num(3)),
+                                  fill(num(4), mem(lea("buf")), num(2))
+                              });
+    Computer computer1(6);
+    computer1.boot(ooasm_fill);
+    assert(memory_dump(computer1) == "7 7 7 0 7 7 ");
+
+    auto ooasm_copy = program({
+                                  mov(mem(num(0)), num(1)),
+                                  mov(mem(num(1)), num(2)),
+                                  mov(mem(num(2)), num(3)),
+                                  copy(num(3), num(0), num(3)),
+                                  copy(num(1), num(0), num(4)), // overlapping, forward
+                                  copy(num(0), num(1), num(2))  // overlapping, backward
+                              });
+    Computer computer2(6);
+    computer2.boot(ooasm_copy);
+    assert(memory_dump(computer2) == "1 2 2 3 1 3 ");
+
+    auto ooasm_vadd = program({
+                                  fill(num(0), num(1), num(4)),
+                                  vadd(num(1), num(0), num(3)), // source read before writing
+                                  mov(mem(num(4)), num(-5)),
+                                  vadd(num(4), num(0), num(1)),
+                                  ones(mem(num(5)))
+                              });
+    Computer computer3(6);
+    computer3.boot(ooasm_vadd);
+    assert(memory_dump(computer3) == "1 2 2 2 -4 1 ");
+
+    // a count of zero touches nothing, also at the end of the memory
+    auto ooasm_empty = program({copy(num(2), num(0), num(0)), vadd(num(2), num(2), num(0))});
+    Computer computer4(2);
+    computer4.boot(ooasm_empty);
+    assert(memory_dump(computer4) == "0 0 ");
+
+    // ranges are checked as a whole before anything is written
+    for (auto& failing : {program({fill(num(1), num(5), num(2))}),
+                          program({copy(num(0), num(1), num(2))}),
+                          program({vadd(num(0), num(-1), num(1))}),
+                          program({fill(num(0), num(5), num(-1))})}) {
+        Computer computer5(2);
+        try {
+            computer5.boot(failing);
+            assert(false);
+        }
+        catch (OutOfBoundsException&) {
+        }
+        assert(memory_dump(computer5) == "0 0 ");
+    }
+}
@@ -0,0 +1,64 @@
+#include "ooasm.h"
+#include "computer.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+
+namespace {
+std::string memory_dump(Computer const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+}
+
+int main() {
+    const auto ooasm_sum = program({
+                                       data("x", num(1)),
+                                       data("y", num(2)),
+                                       data("copy", mem(lea("x"))),
+                                       add(mem(lea("x")), mem(lea("y"))),
+                                       add(mem(num(4)), mem(num(3)))
+                                   });
+    Computer computer(5);
+    computer.boot(ooasm_sum);
+    assert(memory_dump(computer) == "3 2 1 0 0 ");
+
+    BootInput<int64_t> input;
+    input.data_overrides = {{"x", 10}, {"y", -4}};
+    computer.boot(ooasm_sum, input);
+    // overrides take part in the declarations, so "copy" sees the new x
+    assert(memory_dump(computer) == "6 -4 10 0 0 ");
+
+    input.data_overrides = {{"y", 5}};
+    input.memory_image = {0, 0, 0, 7, 8};
+    computer.boot(ooasm_sum, input);
+    // declarations are written over the image
+    assert(memory_dump(computer) == "6 5 1 7 15 ");
+
+    input.memory_image = {9};
+    input.data_overrides.clear();
+    computer.boot(program({inc(mem(num(1)))}), input);
+    assert(memory_dump(computer) == "9 1 0 0 0 ");
+
+    // the next plain boot starts from zeros again
+    computer.boot(ooasm_sum);
+    assert(memory_dump(computer) == "3 2 1 0 0 ");
+
+    input.data_overrides = {{"z", 1}};
+    try {
+        computer.boot(ooasm_sum, input);
+        assert(false);
+    }
+    catch (WrongVarNameException&) {
+    }
+
+    input.data_overrides.clear();
+    input.memory_image.assign(6, 1);
+    try {
+        computer.boot(ooasm_sum, input);
+        assert(false);
+    }
+    catch (MemoryOverflowException&) {
+    }
+}
@@ -0,0 +1,103 @@
+#include "ooasm.h"
+#include "computer.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+
+namespace {
+std::string memory_dump(Computer const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+
+// Many independent counters mixed with flag-dependent instructions and pointer accesses,
+// so the plan contains parallel stages as well as barriers.
+program<> make_program(size_t cells, size_t rounds) {
+    std::vector<InstructionPtr<int64_t>> instructions;
+    instructions.emplace_back(data("ptr", num(0)));
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t i = 1; i < cells; i++) {
+            auto cell = static_cast<int64_t>(i);
+            instructions.emplace_back(add(mem(num(cell)), num(cell)));
+            instructions.emplace_back(mov(mem(num(cell % (cells - 1) + 1)), mem(num(cell))));
+            if (i % 7 == 0) {
+                instructions.emplace_back(sub(mem(num(cell)), num(100)));
+                instructions.emplace_back(ones(mem(num(cell - 1))));
+                instructions.emplace_back(onez(mem(num(cell - 2))));
+            }
+        }
+        instructions.emplace_back(inc(mem(lea("ptr"))));
+        instructions.emplace_back(dec(mem(mem(lea("ptr")))));
+    }
+    for (size_t i = 1; i < cells; i++)
+        instructions.emplace_back(sub(mem(num(static_cast<int64_t>(i))), num(1000000)));
+    return program<>(std::move(instructions));
+}
+}
+
+int main() {
+    auto prog = make_program(5000, 4);
+    // flags survive boot, so they are checked by a program reading them
+    auto read_flags = program({ones(mem(num(0))), onez(mem(num(1)))});
+    Computer sequential(5000);
+    sequential.boot(prog);
+    for (unsigned threads : {1u, 2u, 4u, 16u}) {
+        Computer parallel(5000);
+        parallel.boot_parallel(prog, threads);
+        assert(memory_dump(parallel) == memory_dump(sequential));
+        parallel.boot(read_flags);
+        sequential.boot(read_flags);
+        assert(memory_dump(parallel) == memory_dump(sequential));
+        sequential.boot(prog);
+    }
+
+    // The flags after a parallel stage are those of its last flag write, even when other
+    // components run after it in the same lane, and every component reads the flags the stage
+    // started with, whatever ran before it in its lane.
+    std::vector<InstructionPtr<int64_t>> last_writer;
+    last_writer.emplace_back(data("p", num(2)));
+    for (int64_t i = 3; i < 1203; i++)
+        last_writer.emplace_back(add(mem(num(i)), num(1)));
+    last_writer.emplace_back(sub(mem(num(1)), num(5)));
+    last_writer.emplace_back(ones(mem(mem(lea("p")))));
+    std::vector<InstructionPtr<int64_t>> incoming_flags;
+    incoming_flags.emplace_back(data("p", num(0)));
+    incoming_flags.emplace_back(sub(mem(mem(lea("p"))), num(5)));
+    incoming_flags.emplace_back(ones(mem(num(1))));
+    for (int64_t i = 2; i < 2402; i++)
+        incoming_flags.emplace_back(add(mem(num(i)), num(1)));
+    const std::pair<program<>, std::string> flags_programs[] = {
+        {program<>(std::move(last_writer)), "2 -5 1 "},
+        {program<>(std::move(incoming_flags)), "-5 1 "}};
+    for (const auto& [flags_program, prefix] : flags_programs) {
+        Computer flags_sequential(2500);
+        flags_sequential.boot(flags_program);
+        assert(memory_dump(flags_sequential).substr(0, prefix.size()) == prefix);
+        for (unsigned threads : {2u, 3u, 4u}) {
+            Computer flags_parallel(2500);
+            flags_parallel.boot_parallel(flags_program, threads);
+            assert(memory_dump(flags_parallel) == memory_dump(flags_sequential));
+        }
+    }
+
+    auto ooasm_data = program({
+                                  inc(mem(lea("a"))),
+                                  data("a", num(0)),
+                                  data("b", num(2)),
+                                  data("c", num(3))
+                              });
+    Computer computer1(4);
+    computer1.boot_parallel(ooasm_data, 4);
+    assert(memory_dump(computer1) == "1 2 3 0 ");
+
+    auto out_of_bounds = program({mov(mem(num(0)), num(1)), mov(mem(num(2)), num(1))});
+    Computer computer2(2);
+    try {
+        computer2.boot_parallel(out_of_bounds, 4);
+        assert(false);
+    }
+    catch (OutOfBoundsException&) {
+    }
+    assert(memory_dump(computer2) == "1 0 ");
+}
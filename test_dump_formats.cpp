@@ -0,0 +1,108 @@
+#include "ooasm.h"
+#include "computer.h"
+#include "dump_decoder.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+
+namespace {
+template <typename Word>
+std::string memory_dump(BasicComputer<Word> const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+
+template <typename Word>
+std::string sparse_dump(BasicComputer<Word> const& computer) {
+    std::stringstream ss;
+    computer.memory_dump_sparse(ss);
+    return ss.str();
+}
+
+template <typename Word>
+std::string decoded(const std::string& dump, const std::vector<Word>& base = {}) {
+    std::stringstream input(dump), output;
+    write_dump(output, decode_dump<Word>(input, base));
+    return output.str();
+}
+}
+
+int main() {
+    Computer computer(12);
+    computer.boot(program({
+                              data("a", num(7)),
+                              fill(num(3), num(-2), num(4)),
+                              mov(mem(num(8)), num(-2)),
+                              mov(mem(num(11)), num(5))
+                          }));
+    assert(memory_dump(computer) == "7 0 0 -2 -2 -2 -2 0 -2 0 0 5 ");
+    // runs of equal non-zero values
+    assert(sparse_dump(computer) == "12\n0 1 7\n3 4 -2\n8 1 -2\n11 1 5\n");
+    assert(decoded<int64_t>(sparse_dump(computer)) == memory_dump(computer));
+
+    // a delta lists only what changed since the base, also cells that became zero
+    auto previous = computer.memory_snapshot();
+    computer.boot(program({
+                              data("a", num(7)),
+                              fill(num(4), num(-2), num(2)),
+                              mov(mem(num(8)), num(-2)),
+                              mov(mem(num(9)), num(-2)),
+                              mov(mem(num(11)), num(6))
+                          }));
+    std::stringstream delta;
+    computer.memory_dump_delta(delta, previous);
+    assert(delta.str() == "12\n3 1 0\n6 1 0\n9 1 -2\n11 1 6\n");
+    assert(decoded(delta.str(), previous) == memory_dump(computer));
+
+    // nothing changed, an empty and a zero memory
+    std::stringstream same;
+    computer.memory_dump_delta(same, computer.memory_snapshot());
+    assert(same.str() == "12\n");
+    Computer empty(0);
+    empty.boot(program<>({}));
+    assert(sparse_dump(empty) == "0\n");
+    assert(decoded<int64_t>(sparse_dump(empty)) == memory_dump(empty));
+    Computer zeros(5);
+    zeros.boot(program<>({}));
+    assert(sparse_dump(zeros) == "5\n");
+    assert(decoded<int64_t>(sparse_dump(zeros)) == "0 0 0 0 0 ");
+
+    // a base shorter than the memory is extended with zeros
+    std::stringstream against_short;
+    computer.memory_dump_delta(against_short, {7, 0, 0, 0});
+    assert(decoded(against_short.str(), std::vector<int64_t> {7, 0, 0, 0}) ==
+           memory_dump(computer));
+
+#ifdef __SIZEOF_INT128__
+    Computer128 computer128(3);
+    computer128.boot(program<int128_t>({
+                                           data("a", num<int128_t>(1)),
+                                           add(mem(num<int128_t>(1)), num<int128_t>(INT64_MAX)),
+                                           add(mem(num<int128_t>(1)), num<int128_t>(INT64_MAX)),
+                                           sub(mem(num<int128_t>(2)), mem(num<int128_t>(1)))
+                                       }));
+    assert(decoded<int128_t>(sparse_dump(computer128)) == memory_dump(computer128));
+#endif
+
+    // the size of the memory is limited before anything is allocated
+    std::stringstream too_large("1000\n");
+    try {
+        decode_dump<int64_t>(too_large, {}, 999);
+        assert(false);
+    }
+    catch (DumpFormatException&) {
+    }
+
+    for (const char* invalid : {"", "x", "3\n0 4 1\n", "3\n3 1 1\n", "3\n0 0 1\n", "3\n0 1\n",
+                                "3\n0 1 1x\n", "3\n0 1 99999999999999999999\n",
+                                "-1\n", "99999999999999999999\n", "3\n-1 1 1\n", "3\n0 -1 1\n"}) {
+        std::stringstream input(invalid);
+        try {
+            decode_dump<int64_t>(input);
+            assert(false);
+        }
+        catch (DumpFormatException&) {
+        }
+    }
+}
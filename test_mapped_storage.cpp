@@ -0,0 +1,68 @@
+#include "ooasm.h"
+#include "computer.h"
+#include "mapped_storage.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+std::string memory_dump(Computer const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+}
+
+int main() {
+    char path[] = "/tmp/ooasm_image_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    auto ooasm_data = program({
+                                  inc(mem(lea("a"))),
+                                  data("a", num(0)),
+                                  data("b", num(2)),
+                                  data("c", num(-3))
+                              });
+    {
+        Computer computer(std::make_unique<MappedStorage<int64_t>>(path, 4));
+        computer.boot(ooasm_data);
+        computer.checkpoint();
+        assert(memory_dump(computer) == "1 2 -3 0 ");
+    }
+
+    // the image is the raw array of words
+    std::ifstream image(path, std::ios::binary);
+    int64_t cells[4];
+    image.read(reinterpret_cast<char*>(cells), sizeof(cells));
+    assert(image.gcount() == sizeof(cells));
+    assert(cells[0] == 1 && cells[1] == 2 && cells[2] == -3 && cells[3] == 0);
+
+    // restarting from an existing image
+    Computer restarted(std::make_unique<MappedStorage<int64_t>>(path, 4));
+    assert(memory_dump(restarted) == "1 2 -3 0 ");
+    auto next_step = program({data("a", num(10)), add(mem(num(1)), mem(num(2))),
+                              inc(mem(num(3)))});
+    restarted.boot_in_place(next_step);
+    restarted.checkpoint();
+    assert(memory_dump(restarted) == "10 -1 -3 1 ");
+    {
+        Computer reopened(std::make_unique<MappedStorage<int64_t>>(path, 4));
+        reopened.boot_in_place(next_step);
+        assert(memory_dump(reopened) == "10 -4 -3 2 ");
+        // a plain boot starts from zeros again
+        reopened.boot(next_step);
+        assert(memory_dump(reopened) == "10 0 0 1 ");
+    }
+
+    try {
+        MappedStorage<int64_t> wrong_size(path, 5);
+        assert(false);
+    }
+    catch (ImageSizeMismatchException&) {
+    }
+    std::remove(path);
+}
@@ -0,0 +1,34 @@
+#include "ooasm.h"
+#include "computer.h"
+#include "perf_counters.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+
+int main() {
+    auto ooasm_data = program({
+                                  inc(mem(lea("a"))),
+                                  data("a", num(0)),
+                                  data("b", num(2)),
+                                  data("c", num(3))
+                              });
+    BootProfile profile;
+    Computer computer(4);
+    computer.boot(ooasm_data, profile);
+    computer.boot(ooasm_data, profile);
+    std::stringstream dump;
+    computer.memory_dump(dump, profile);
+    assert(dump.str() == "1 2 3 0 ");
+    assert(profile.get_instructions_executed() == 8);
+
+    // counters may be missing (no PMU, perf_event_paranoid), but never report garbage
+    HardwareCounters counters;
+    for (auto event : {HardwareEvent::CYCLES, HardwareEvent::DTLB_MISSES}) {
+        if (!counters.is_available(event))
+            assert(!profile.get(BootPhase::EXECUTION, event));
+    }
+
+    std::stringstream report;
+    profile.report(report);
+    assert(report.str().find("execution") != std::string::npos);
+}
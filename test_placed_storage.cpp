@@ -0,0 +1,81 @@
+#include "ooasm.h"
+#include "computer.h"
+#include "placed_storage.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+#include <thread>
+
+namespace {
+std::string memory_dump(Computer const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+
+const auto ooasm_program = program({
+                                       data("a", num(2)),
+                                       data("p", num(3)),
+                                       add(mem(mem(lea("p"))), mem(lea("a"))),
+                                       vadd(num(1), num(0), num(2))
+                                   });
+const std::string expected = "2 5 3 2 ";
+
+void check(const MemoryPlacement& placement) {
+    Computer computer(std::make_unique<PlacedStorage<int64_t>>(4, placement));
+    computer.boot(ooasm_program);
+    assert(memory_dump(computer) == expected);
+    computer.boot(ooasm_program);
+    assert(memory_dump(computer) == expected);
+}
+}
+
+int main() {
+    check(MemoryPlacement {});
+    // transparent huge pages may be disabled, but the advice is still accepted
+    check(MemoryPlacement {PageSize::TRANSPARENT, NumaPolicy::DEFAULT, {}});
+
+    // the hugetlb pool is usually empty unless reserved by the administrator
+    for (auto pages : {PageSize::HUGE_2MB, PageSize::HUGE_1GB}) {
+        try {
+            check(MemoryPlacement {pages, NumaPolicy::DEFAULT, {}});
+        }
+        catch (std::system_error&) {
+        }
+    }
+
+    // node 0 exists on every machine, unless the kernel was built without NUMA support
+    for (auto policy : {NumaPolicy::BIND, NumaPolicy::INTERLEAVE}) {
+        try {
+            check(MemoryPlacement {PageSize::TRANSPARENT, policy, {0}});
+        }
+        catch (std::system_error&) {
+        }
+    }
+
+    for (const auto& nodes : {std::vector<unsigned> {}, std::vector<unsigned> {4096}}) {
+        try {
+            PlacedStorage<int64_t> storage(4, MemoryPlacement {PageSize::DEFAULT,
+                                                               NumaPolicy::BIND, nodes});
+            assert(false);
+        }
+        catch (InvalidNumaNodeException&) {
+        }
+        catch (std::system_error&) {
+        }
+    }
+
+    PlacedStorage<int64_t> empty(0, MemoryPlacement {});
+    assert(empty.size() == 0);
+
+    std::thread([] {
+        pin_thread_to_numa_node(0);
+        check(MemoryPlacement {PageSize::DEFAULT, NumaPolicy::DEFAULT, {}});
+    }).join();
+    try {
+        pin_thread_to_numa_node(4096);
+        assert(false);
+    }
+    catch (InvalidNumaNodeException&) {
+    }
+}
@@ -0,0 +1,138 @@
+#include "ooasm.h"
+#include "computer.h"
+#include "program_stream.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+
+#include <unistd.h>
+
+namespace {
+template <typename Word>
+std::string memory_dump(BasicComputer<Word> const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+
+void write_file(const char* path, const std::string& text) {
+    std::ofstream file(path, std::ios::trunc);
+    file << text;
+}
+}
+
+int main() {
+    char path[] = "/tmp/ooasm_program_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    // the same program in both forms; "x" is used before its declaration
+    const auto ooasm_program = program({
+                                           add(mem(lea("x")), num(5)),
+                                           data("x", num(-2)),
+                                           data("y", mem(lea("x"))),
+                                           mov(reg(3), lea("y")),
+                                           inc(mem(reg(3))),
+                                           sub(mem(num(4)), num(1)),
+                                           ones(mem(num(5))),
+                                           dec(mem(num(6))),
+                                           onez(mem(num(7))),
+                                           one(mem(num(2))),
+                                           fill(num(8), mem(lea("x")), num(4)),
+                                           copy(num(12), num(8), num(2)),
+                                           vadd(num(13), num(0), num(3))
+                                       });
+    write_file(path, "add mem lea x num 5\n"
+                     "data x num -2\n"
+                     "\n"
+                     "# comments and empty lines are skipped\n"
+                     "data y mem lea x\n"
+                     "mov reg 3 lea y\n"
+                     "inc mem reg 3\n"
+                     "sub mem num 4 num 1\n"
+                     "ones mem num 5\n"
+                     "  dec   mem num 6\n"
+                     "onez mem num 7\n"
+                     "one mem num 2\n"
+                     "fill num 8 mem lea x num 4\n"
+                     "copy num 12 num 8 num 2\n"
+                     "vadd num 13 num 0 num 3");
+    Computer reference(16);
+    reference.boot(ooasm_program);
+    const auto expected = memory_dump(reference);
+    assert(expected == "3 -1 1 0 -1 1 -1 0 3 3 3 3 3 6 -1 1 ");
+
+    // windows smaller than, equal to and larger than the program, and ending exactly at its end
+    for (size_t window_size : {1, 2, 3, 13, 1000}) {
+        Computer computer(16);
+        computer.boot(ProgramStream<>(path, window_size));
+        assert(memory_dump(computer) == expected);
+    }
+
+    // a stream can be booted many times and profiled like a program
+    const ProgramStream<> stream(path, 4);
+    Computer computer(16);
+    BootProfile profile;
+    computer.boot(stream, profile);
+    computer.boot(stream, profile);
+    assert(memory_dump(computer) == expected);
+    assert(profile.get_instructions_executed() == 26);
+
+    // numbers are read with the full range of the word
+    write_file(path, "data a num -170141183460469231731687303715884105728\n"
+                     "data b num 170141183460469231731687303715884105727\n");
+#ifdef __SIZEOF_INT128__
+    Computer128 computer128(2);
+    computer128.boot(ProgramStream<int128_t>(path));
+    assert(memory_dump(computer128) ==
+           "-170141183460469231731687303715884105728 170141183460469231731687303715884105727 ");
+#endif
+    try {
+        computer.boot(ProgramStream<>(path));
+        assert(false);
+    }
+    catch (ProgramSyntaxException&) {
+    }
+
+    for (const char* invalid : {"jmp num 1", "add num 1 num 2", "inc mem", "data x num 1 num 2",
+                                "mov mem num 0 num 1x", "inc reg 16", "inc reg -1",
+                                "mov mem reg -1 num 1", "data x num -"}) {
+        write_file(path, std::string("data a num 1\n") + invalid + "\n");
+        try {
+            computer.boot(ProgramStream<>(path, 1));
+            assert(false);
+        }
+        catch (ProgramSyntaxException&) {
+        }
+    }
+#ifdef __SIZEOF_INT128__
+    // 2^64 would wrap to register 0 if it was cast before the check
+    write_file(path, "mov reg 18446744073709551616 num 7\n");
+    try {
+        computer128.boot(ProgramStream<int128_t>(path));
+        assert(false);
+    }
+    catch (ProgramSyntaxException&) {
+    }
+#endif
+
+    // errors of the machine are the same as for programs
+    write_file(path, "inc mem lea z\n");
+    try {
+        computer.boot(ProgramStream<>(path));
+        assert(false);
+    }
+    catch (WrongVarNameException&) {
+    }
+
+    std::remove(path);
+    try {
+        computer.boot(ProgramStream<>(path));
+        assert(false);
+    }
+    catch (std::system_error&) {
+    }
+}
@@ -0,0 +1,59 @@
+#include "ooasm.h"
+#include "computer.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+
+namespace {
+std::string memory_dump(Computer const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+}
+
+int main() {
+    auto ooasm_registers = program({
+                                       data("a", num(5)),
+                                       mov(reg(0), mem(lea("a"))),
+                                       add(reg(0), num(10)),
+                                       sub(reg(1), reg(0)),
+                                       ones(reg(2)),
+                                       mov(mem(num(1)), reg(1)),
+                                       inc(reg(3)),
+                                       mov(mem(reg(3)), reg(2)),
+                                       add(mem(lea("a")), reg(0))
+                                   });
+    Computer computer1(3);
+    computer1.boot(ooasm_registers);
+    // registers are not a part of the dump
+    assert(memory_dump(computer1) == "20 1 0 ");
+
+    // registers start from zero on every boot
+    computer1.boot(ooasm_registers);
+    assert(memory_dump(computer1) == "20 1 0 ");
+    auto ooasm_dirty = program({onez(reg(4)), add(mem(num(0)), reg(4)), mov(reg(5), num(7))});
+    auto ooasm_clean = program({mov(mem(num(0)), reg(5))});
+    computer1.boot(ooasm_dirty);
+    computer1.boot(ooasm_clean);
+    assert(memory_dump(computer1) == "0 0 0 ");
+
+    try {
+        reg(REGISTER_COUNT);
+        assert(false);
+    }
+    catch (InvalidRegisterException&) {
+    }
+
+    // independent register chains are found by dataflow-parallel execution as well
+    std::vector<InstructionPtr<int64_t>> instructions;
+    for (int64_t i = 0; i < 4000; i++) {
+        instructions.emplace_back(add(reg(i % REGISTER_COUNT), num(i)));
+        instructions.emplace_back(mov(mem(num(i % 100)), reg(i % REGISTER_COUNT)));
+    }
+    const program<> registers_only(std::move(instructions));
+    Computer sequential(100), parallel(100);
+    sequential.boot(registers_only);
+    parallel.boot_parallel(registers_only, 4);
+    assert(memory_dump(parallel) == memory_dump(sequential));
+}
@@ -0,0 +1,144 @@
+#include "ooasm.h"
+#include "computer.h"
+#include "result_cache.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace {
+std::string memory_dump(Computer const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+
+std::vector<std::string> list_files(const char* directory) {
+    std::vector<std::string> names;
+    DIR* dir = opendir(directory);
+    assert(dir != nullptr);
+    while (auto entry = readdir(dir))
+        if (entry->d_name[0] != '.')
+            names.push_back(std::string(directory) + "/" + entry->d_name);
+    closedir(dir);
+    return names;
+}
+}
+
+int main() {
+    auto ooasm_data = program({
+                                  inc(mem(lea("a"))),
+                                  data("a", num(0)),
+                                  data("b", num(2)),
+                                  data("c", num(3))
+                              });
+    auto same_data = program({
+                                 inc(mem(lea("a"))),
+                                 data("a", num(0)),
+                                 data("b", num(2)),
+                                 data("c", num(3))
+                             });
+    auto other_data = program({
+                                  inc(mem(lea("a"))),
+                                  data("a", num(0)),
+                                  data("b", num(2)),
+                                  data("c", num(4))
+                              });
+    assert(ooasm_data.content_hash() == same_data.content_hash());
+    assert(!(ooasm_data.content_hash() == other_data.content_hash()));
+
+    const size_t entry_bytes = 4 * sizeof(int64_t) + ResultCache<int64_t>::ENTRY_OVERHEAD_BYTES;
+    ResultCache<int64_t> cache(2 * entry_bytes);
+    Computer computer(4);
+    computer.boot(ooasm_data, cache);
+    assert(memory_dump(computer) == "1 2 3 0 ");
+    computer.boot(other_data, cache);
+    assert(memory_dump(computer) == "1 2 4 0 ");
+    computer.boot(same_data, cache);
+    assert(memory_dump(computer) == "1 2 3 0 ");
+    assert(cache.get_statistics().hits == 1 && cache.get_statistics().misses == 2 &&
+           cache.get_statistics().evictions == 0);
+
+    // flags left by the previous boot are a part of the key
+    auto flag_reader = program({onez(mem(num(0)))});
+    auto set_zero = program({sub(mem(num(1)), num(0))});
+    auto set_sign = program({dec(mem(num(1)))});
+    computer.boot(set_zero, cache);
+    computer.boot(flag_reader, cache);
+    assert(memory_dump(computer) == "1 0 0 0 ");
+    computer.boot(set_sign, cache);
+    computer.boot(flag_reader, cache);
+    assert(memory_dump(computer) == "0 0 0 0 ");
+    assert(cache.get_statistics().evictions > 0);
+
+    // the exception ending a run is remembered as well
+    auto failing = program({mov(mem(num(0)), num(7)), mov(mem(num(4)), num(1))});
+    for (int run = 0; run < 2; run++) {
+        try {
+            computer.boot(failing, cache);
+            assert(false);
+        }
+        catch (OutOfBoundsException&) {
+        }
+        assert(memory_dump(computer) == "7 0 0 0 ");
+    }
+
+    // outcomes of empty memories take room as well, so the cache stays bounded
+    ResultCache<int64_t> small(ResultCache<int64_t>::ENTRY_OVERHEAD_BYTES);
+    Computer empty(0);
+    for (int64_t i = 0; i < 100; i++)
+        empty.boot(program({mov(reg(0), num(i))}), small);
+    assert(small.get_statistics().bytes == ResultCache<int64_t>::ENTRY_OVERHEAD_BYTES);
+    assert(small.get_statistics().evictions == 99);
+
+    // outcomes stored on disk survive the cache
+    char directory[] = "/tmp/ooasm_cache_XXXXXX";
+    [[maybe_unused]] auto created = mkdtemp(directory);
+    assert(created != nullptr);
+    {
+        ResultCache<int64_t> persistent(0, std::string(directory));
+        Computer first(4);
+        first.boot(ooasm_data, persistent);
+    }
+    ResultCache<int64_t> reopened(1 << 20, std::string(directory));
+    Computer second(4);
+    second.boot(same_data, reopened);
+    assert(memory_dump(second) == "1 2 3 0 ");
+    assert(reopened.get_statistics().disk_hits == 1);
+
+    // a file with an unknown error or flag bits is a miss and gets rewritten
+    auto files = list_files(directory);
+    assert(files.size() == 1);
+    for (uint64_t damaged : {uint64_t(9) << 8, uint64_t(1) << 4}) {
+        {
+            std::fstream file(files[0], std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(3 * sizeof(uint64_t));
+            file.write(reinterpret_cast<const char*>(&damaged), sizeof(damaged));
+        }
+        ResultCache<int64_t> damaged_cache(0, std::string(directory));
+        Computer third(4);
+        third.boot(same_data, damaged_cache);
+        assert(memory_dump(third) == "1 2 3 0 ");
+        assert(damaged_cache.get_statistics().misses == 1);
+    }
+
+    // a failed store leaves no temporary file behind
+    std::remove(files[0].c_str());
+    [[maybe_unused]] auto blocked_path = mkdir(files[0].c_str(), 0755);
+    assert(blocked_path == 0);
+    std::ofstream(files[0] + "/keep");
+    ResultCache<int64_t> blocked(0, std::string(directory));
+    Computer fourth(4);
+    fourth.boot(same_data, blocked);
+    assert(memory_dump(fourth) == "1 2 3 0 ");
+    assert(list_files(directory) == files);
+
+    std::remove((files[0] + "/keep").c_str());
+    rmdir(files[0].c_str());
+    rmdir(directory);
+}
@@ -0,0 +1,59 @@
+#include "ooasm.h"
+#include "computer.h"
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <cassert>
+#include <thread>
+
+namespace {
+std::string memory_dump(Computer const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+}
+
+int main() {
+    std::vector<InstructionPtr<int64_t>> instructions;
+    instructions.emplace_back(data("ptr", num(1)));
+    for (int64_t i = 1; i < 1000; i++) {
+        instructions.emplace_back(add(mem(mem(lea("ptr"))), num(i)));
+        instructions.emplace_back(onez(mem(num(i))));
+        instructions.emplace_back(inc(mem(lea("ptr"))));
+    }
+    const program<> shared(std::move(instructions));
+
+    Computer reference(1000);
+    reference.boot(shared);
+    const auto expected = memory_dump(reference);
+
+    // one program, many computers booting it at the same time
+    std::vector<std::thread> threads;
+    std::vector<std::string> dumps(8);
+    for (size_t t = 0; t < dumps.size(); t++) {
+        threads.emplace_back([&, t] {
+            Computer computer(1000);
+            for (int run = 0; run < 10; run++)
+                computer.boot(shared);
+            dumps[t] = memory_dump(computer);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    assert(std::all_of(dumps.begin(), dumps.end(),
+                       [&](const std::string& dump) { return dump == expected; }));
+
+    // a program can also be booted again after an exception interrupted its previous run
+    auto failing = program({inc(mem(lea("a"))), data("a", num(0)), mov(mem(num(5)), num(1))});
+    Computer computer(1);
+    for (int run = 0; run < 2; run++) {
+        try {
+            computer.boot(failing);
+            assert(false);
+        }
+        catch (OutOfBoundsException&) {
+        }
+        assert(memory_dump(computer) == "1 ");
+    }
+}
@@ -0,0 +1,54 @@
+#include "ooasm.h"
+#include "computer.h"
+#include <string>
+#include <sstream>
+#include <cassert>
+
+namespace {
+template <typename Word>
+std::string memory_dump(BasicComputer<Word> const& computer) {
+    std::stringstream ss;
+    computer.memory_dump(ss);
+    return ss.str();
+}
+}
+
+int main() {
+    auto ooasm32 = program<int32_t>({
+                                        data("a", num<int32_t>(INT32_MAX)),
+                                        data("b", num<int32_t>(INT32_MIN)),
+                                        dec(mem(lea<int32_t>("a"))),
+                                        ones(mem(num<int32_t>(2))),
+                                        inc(mem(lea<int32_t>("b"))),
+                                        ones(mem(num<int32_t>(3)))
+                                    });
+    Computer32 computer1(4);
+    computer1.boot(ooasm32);
+    assert(memory_dump(computer1) == "2147483646 -2147483647 0 1 ");
+
+    auto ooasm32_bounds = program<int32_t>({mov(mem(num<int32_t>(-1)), num<int32_t>(1))});
+    Computer32 computer2(1);
+    try {
+        computer2.boot(ooasm32_bounds);
+        assert(false);
+    }
+    catch (OutOfBoundsException&) {
+    }
+
+#ifdef __SIZEOF_INT128__
+    auto ooasm128 = program<int128_t>({
+                                          data("big", num<int128_t>(INT64_MAX)),
+                                          add(mem(lea<int128_t>("big")), mem(lea<int128_t>("big"))),
+                                          sub(mem(num<int128_t>(1)), mem(lea<int128_t>("big"))),
+                                          sub(mem(num<int128_t>(1)), mem(lea<int128_t>("big")))
+                                      });
+    Computer128 computer3(2);
+    computer3.boot(ooasm128);
+    assert(memory_dump(computer3) == "18446744073709551614 -36893488147419103228 ");
+#endif
+
+    auto ooasm64 = program({data("a", num(INT64_MIN)), inc(mem(lea("a")))});
+    Computer computer4(1);
+    computer4.boot(ooasm64);
+    assert(memory_dump(computer4) == "-9223372036854775807 ");
+}